@@ -11,19 +11,42 @@
 #include <cli/cli_main.hpp>
 #include <cli/text_io_handler.hpp>
 #include <script/functions/functions.hpp>
+#include <script/functions/util.hpp>
 #include <script/profiler.hpp>
 #include <data/format/formats.hpp>
+#include <data/pack.hpp>
+#include <data/card.hpp>
+#include <data/export_template.hpp>
+#include <data/settings.hpp>
+#include <gui/print_window.hpp>
 #include <wx/process.h>
 #include <wx/wfstream.h>
+#include <wx/thread.h>
+#ifndef __WXMSW__
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/wait.h>
+	#include <sys/select.h>
+	#include <unistd.h>
+	#include <signal.h>
+	#include <errno.h>
+#endif
+#ifdef __GNUC__
+	#include <cxxabi.h>
+#endif
 
 String read_utf8_line(wxInputStream& input, bool eat_bom = true, bool until_eof = false);
+ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTemplateP const& exp, String const& outname);
 
 DECLARE_TYPEOF_COLLECTION(ScriptParseError);
+DECLARE_TYPEOF_COLLECTION(PackTypeStatistics);
+DECLARE_TYPEOF_COLLECTION(pair<CardP COMMA size_t>);
 
 // ----------------------------------------------------------------------------- : Command line interface
 
-CLISetInterface::CLISetInterface(const SetP& set, bool quiet)
+CLISetInterface::CLISetInterface(const SetP& set, bool quiet, bool test_functions)
 	: quiet(quiet)
+	, test_functions(test_functions)
 	, our_context(nullptr)
 {
 	if (!cli.haveConsole()) {
@@ -61,9 +84,27 @@ void CLISetInterface::onBeforeChangeSet() {
 }
 
 void CLISetInterface::onChangeSet() {
+	openScope();
+	ei.set = set;
+}
+
+// ----------------------------------------------------------------------------- : Functions for testing
+
+// Number of instructions in the compiled code of a function, to check what the parser optimizes
+SCRIPT_FUNCTION(instruction_count) {
+	SCRIPT_PARAM_C(ScriptValueP, input);
+	ScriptP script = dynamic_pointer_cast<Script>(input);
+	if (!script) throw ScriptErrorConversion(input->typeName(), _TYPE_("function"));
+	SCRIPT_RETURN((int)script->getInstructions().size());
+}
+
+void CLISetInterface::openScope() {
 	Context& ctx = getContext();
 	scope = ctx.openScope();
-	ei.set = set;
+	if (test_functions) {
+		// these are in the scope, so they are gone when it is closed
+		ctx.setVariable(_("instruction_count"), script_instruction_count);
+	}
 }
 
 void CLISetInterface::setExportInfoCwd() {
@@ -96,11 +137,86 @@ void CLISetInterface::run_interactive() {
 	}
 }
 
+void CLISetInterface::run_server(String const& socket_path) {
+	#ifdef __WXMSW__
+		throw Error(_("Server mode is not supported on this platform"));
+	#else
+		// listen on the socket
+		wxCharBuffer path = socket_path.fn_str();
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(path) >= sizeof(addr.sun_path)) {
+			throw Error(_("Socket path is too long: ") + socket_path);
+		}
+		strcpy(addr.sun_path, path);
+		int server = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (server < 0) {
+			throw Error(_("Unable to create socket: ") + socket_path);
+		}
+		unlink(path); // remove a stale socket left by an earlier server
+		if (bind(server, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(server, SOMAXCONN) < 0) {
+			close(server);
+			throw Error(_("Unable to listen on socket: ") + socket_path);
+		}
+		signal(SIGPIPE, SIG_IGN); // clients may disconnect at any time
+		cli.print_pending_errors();
+		cli.flushRaw();
+		// serve connections
+		int max_workers = max(1, wxThread::GetCPUCount());
+		int workers = 0;
+		while (true) {
+			// clean up finished workers, wait for one to finish if there are too many
+			while (workers > 0) {
+				if (waitpid(-1, nullptr, workers >= max_workers ? 0 : WNOHANG) <= 0) break;
+				--workers;
+			}
+			// wait for a connection, but not for long, so finished workers are cleaned up soon
+			fd_set fds;
+			FD_ZERO(&fds);
+			FD_SET(server, &fds);
+			timeval timeout = {1, 0};
+			int ready = select(server + 1, &fds, nullptr, nullptr, &timeout);
+			if (ready < 0 && errno != EINTR) break;
+			if (ready <= 0) continue;
+			int connection = accept(server, nullptr, nullptr);
+			if (connection < 0) {
+				if (errno == EINTR) continue;
+				break;
+			}
+			fflush(stdout);
+			// fork() only copies this thread, locks held by other threads would stay locked in the worker,
+			// so no other threads may be running here, see run_server in cli_main.hpp
+			pid_t pid = fork();
+			if (pid == 0) {
+				// worker: commands come in on the connection, records go out over it
+				close(server);
+				dup2(connection, STDIN_FILENO);
+				dup2(connection, STDOUT_FILENO);
+				close(connection);
+				clearerr(stdin);
+				run_interactive();
+				fflush(stdout);
+				_exit(EXIT_SUCCESS);
+			} else if (pid > 0) {
+				++workers;
+			} else {
+				cli.show_message(MESSAGE_ERROR, _("Unable to start a worker for a connection"));
+				cli.flushRaw();
+			}
+			close(connection);
+		}
+		close(server);
+		unlink(path);
+	#endif
+}
+
 bool CLISetInterface::run_script(ScriptP const& script) {
 	try {
 		WITH_DYNAMIC_ARG(export_info, &ei);
 		Context& ctx = getContext();
 		ScriptValueP result = ctx.eval(*script,false);
+		ei.image_writer.finish();
 		// show result (?)
 		cli << result->toCode() << ENDL;
 		return true;
@@ -162,6 +278,19 @@ void CLISetInterface::showUsage() {
 	cli << _("   :pwd                Print the current working directory.\n");
 	cli << _("   :cd                 Change the working directory.\n");
 	cli << _("   :! <command>        Perform a shell command.\n");
+	cli << _("   :simulate [-j<threads>] <n> <seed> <pack>\n");
+	cli << _("                       Generate n packs of the given type, show card statistics.\n");
+	cli << _("                       The results only depend on the seed, not on the number of threads.\n");
+	cli << _("   :export <template> [<outfile>]\n");
+	cli << _("                       Export the set using an export template.\n");
+	cli << _("   :print <outfile> [<dpi>]\n");
+	cli << _("                       Render all cards to A4 sheets for printing, one image file per page.\n");
+	#if USE_SCRIPT_PROFILING
+		cli << _("   :profile [<level>|full|threads|stages|listeners]\n");
+		cli << _("                       Show profiling statistics.\n");
+		cli << _("   :profile trace [<outfile>]\n");
+		cli << _("                       Start recording a trace, or write it to a Chrome trace file.\n");
+	#endif
 	cli << _("\n Commands can be abreviated to their first letter if there is no ambiguity.\n\n");
 }
 
@@ -191,7 +320,7 @@ void CLISetInterface::handleCommand(const String& command) {
 				Context& ctx = getContext();
 				ei.exported_images.clear();
 				ctx.closeScope(scope);
-				scope = ctx.openScope();
+				openScope();
 			} else if (before == _(":i") || before == _(":info")) {
 				if (set) {
 					cli << _("set:      ") << set->identification() << ENDL;
@@ -228,15 +357,15 @@ void CLISetInterface::handleCommand(const String& command) {
 						system(arg.c_str());
 					#endif
 				}
+			} else if (before == _(":s") || before == _(":simulate")) {
+				simulatePacks(arg);
+			} else if (before == _(":e") || before == _(":export")) {
+				exportSet(arg);
+			} else if (before == _(":print")) {
+				printSet(arg);
 			#if USE_SCRIPT_PROFILING
 				} else if (before == _(":profile")) {
-					if (arg == _("full")) {
-						showProfilingStats(profile_root);
-					} else {
-						long level = 1;
-						arg.ToLong(&level);
-						showProfilingStats(profile_aggregated(level));
-					}
+					profileCommand(arg);
 			#endif
 			} else {
 				cli.show_message(MESSAGE_ERROR,_("Unknown command, type :help for help."));
@@ -253,8 +382,175 @@ void CLISetInterface::handleCommand(const String& command) {
 	}
 }
 
+void CLISetInterface::exportSet(const String& arg) {
+	if (!set) {
+		cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+		return;
+	}
+	if (arg.empty()) {
+		cli.show_message(MESSAGE_ERROR,_("Usage: :export <export template> [<output file>]"));
+		return;
+	}
+	// arguments: template [outfile]
+	size_t space = arg.find_first_of(_(' '));
+	String template_name = arg.substr(0, space);
+	String out = space == String::npos ? String() : arg.substr(space + 1);
+	ExportTemplateP exp = ExportTemplate::byName(template_name);
+	ScriptValueP result = export_set(set, set->cards, exp, out);
+	if (out.empty()) {
+		cli << result->toString() << ENDL;
+	}
+}
+
+void CLISetInterface::printSet(const String& arg) {
+	if (!set) {
+		cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+		return;
+	}
+	if (arg.empty()) {
+		cli.show_message(MESSAGE_ERROR,_("Usage: :print <output file> [<dpi>]"));
+		return;
+	}
+	// arguments: outfile [dpi]
+	size_t space = arg.find_last_of(_(' '));
+	String out = arg;
+	double dpi = 300;
+	if (space != String::npos && arg.substr(space + 1).ToDouble(&dpi) && dpi > 0) {
+		out = arg.substr(0, space);
+	} else {
+		dpi = 300;
+	}
+	PrintJobP job = intrusive(new PrintJob(set));
+	job->cards       = set->cards;
+	job->layout_type = settings.print_layout;
+	print_to_images(job, out, dpi, RealSize(210, 297)); // A4
+	cli << String::Format(_("%d pages written"), job->num_pages()) << ENDL;
+}
+
+void CLISetInterface::simulatePacks(const String& arg) {
+	if (!set) {
+		cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+		return;
+	}
+	// arguments: [-jthreads] count seed pack-name
+	String args = arg;
+	long threads = 0;
+	if (starts_with(args, _("-j"))) {
+		size_t space = args.find_first_of(_(' '));
+		if (space == String::npos || !args.substr(2,space-2).ToLong(&threads) || threads <= 0) {
+			cli.show_message(MESSAGE_ERROR,_("Usage: :simulate [-j<threads>] <number of packs> <seed> <pack type>"));
+			return;
+		}
+		args = args.substr(space+1);
+	}
+	size_t space1 = args.find_first_of(_(' '));
+	size_t space2 = space1 == String::npos ? String::npos : args.find_first_of(_(' '), space1 + 1);
+	unsigned long packs = 0;
+	long seed = 0;
+	if (space2 == String::npos || !args.substr(0,space1).ToULong(&packs)
+	                           || !args.substr(space1+1,space2-space1-1).ToLong(&seed)) {
+		cli.show_message(MESSAGE_ERROR,_("Usage: :simulate [-j<threads>] <number of packs> <seed> <pack type>"));
+		return;
+	}
+	PackSimulation sim(set, args.substr(space2+1));
+	sim.run(packs, (int)seed, (int)threads);
+	if (sim.packs == 0) return;
+	// pack types
+	cli << GRAY << _("Expected  Average   Pack type") << ENDL;
+	cli <<         _("========  ========  ===============================") << NORMAL << ENDL;
+	FOR_EACH(pt, sim.pack_types) {
+		cli << String::Format(_("%8.4f  %8.4f  %s"), pt.expected_copies, (double)pt.total_copies / sim.packs, pt.name.c_str()) << ENDL;
+		for (size_t n = 0 ; n < pt.distribution.size() ; ++n) {
+			if (pt.distribution[n] == 0) continue;
+			cli << String::Format(_("          %8.4f    %d cards"), (double)pt.distribution[n] / sim.packs, (int)n) << ENDL;
+		}
+	}
+	// cards
+	cli << ENDL << GRAY << _("Average   Card") << ENDL;
+	cli <<                 _("========  ===============================") << NORMAL << ENDL;
+	FOR_EACH(c, sim.card_counts) {
+		cli << String::Format(_("%8.4f  %s"), (double)c.second / sim.packs, c.first->identification().c_str()) << ENDL;
+	}
+}
+
 #if USE_SCRIPT_PROFILING
 	DECLARE_TYPEOF_COLLECTION(FunctionProfileP);
+	DECLARE_TYPEOF_COLLECTION(const FunctionProfile*);
+	DECLARE_TYPEOF_COLLECTION(ActionListener*);
+	
+	/// Readable name of a type, type_info::name() gives a mangled name with gcc
+	String type_name(const std::type_info& type) {
+		#ifdef __GNUC__
+			int status = 0;
+			char* name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+			if (name) {
+				String ret(name, IF_UNICODE(wxConvLocal, wxSTRING_MAXLEN));
+				free(name);
+				return ret;
+			}
+		#endif
+		return String(type.name(), IF_UNICODE(wxConvLocal, wxSTRING_MAXLEN));
+	}
+	
+	void CLISetInterface::profileCommand(const String& arg) {
+		if (arg == _("full")) {
+			showProfilingStats(profile_root);
+		} else if (arg == _("threads")) {
+			vector<const FunctionProfile*> roots;
+			profile_threads(roots);
+			FOR_EACH(r, roots) {
+				cli << BRIGHT << r->name << NORMAL << ENDL;
+				showProfilingStats(*r);
+			}
+		} else if (arg == _("stages")) {
+			vector<const FunctionProfile*> roots;
+			profile_threads(roots);
+			FOR_EACH(r, roots) {
+				cli << BRIGHT << r->name << NORMAL << ENDL;
+				showProfilingStages(*r);
+			}
+		} else if (arg == _("listeners")) {
+			if (!set) {
+				cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+				return;
+			}
+			cli << GRAY << _("Actions   Listener") << ENDL;
+			cli <<         _("========  ========") << NORMAL << ENDL;
+			FOR_EACH_CONST(l, set->actions.getListeners()) {
+				cli << String::Format(_("%8d  "), (int)l->actions_received) << type_name(typeid(*l)) << ENDL;
+			}
+			return;
+		} else if (arg == _("trace")) {
+			profile_trace_start();
+			cli << _("Recording trace") << ENDL;
+			return;
+		} else if (arg.StartsWith(_("trace "))) {
+			if (!profile_tracing()) {
+				cli.show_message(MESSAGE_ERROR,_("No trace is being recorded, start one with :profile trace"));
+				return;
+			}
+			profile_trace_write(arg.substr(6));
+			cli << _("Trace written to ") << arg.substr(6) << ENDL;
+			return;
+		} else {
+			long level = 1;
+			arg.ToLong(&level);
+			showProfilingStats(profile_aggregated(level));
+		}
+		cli << String::Format(_("Values: %d pooled, %d large, %d shared"),
+		                      (int)script_allocations.pooled, (int)script_allocations.large, (int)script_allocations.shared) << ENDL;
+	}
+	
+	void CLISetInterface::showProfilingStages(const FunctionProfile& root) {
+		ProfileTime times[PROFILE_STAGE_COUNT];
+		profile_stage_times(root, times);
+		cli << GRAY << _("Time(s)   Stage") << ENDL;
+		cli <<         _("========  ========") << NORMAL << ENDL;
+		for (int i = 0 ; i < PROFILE_STAGE_COUNT ; ++i) {
+			cli << String::Format(_("%8.5f  %s"), times[i] / (double)timer_resolution(), profile_stage_name((ProfileStage)i)) << ENDL;
+		}
+	}
+	
 	void CLISetInterface::showProfilingStats(const FunctionProfile& item, int level) {
 		// show parent
 		if (level == 0) {
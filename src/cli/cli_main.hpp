@@ -19,32 +19,53 @@
 class CLISetInterface : public SetView {
   public:
 	/// The set is optional
-	CLISetInterface(const SetP& set, bool quiet = false);
+	/** With test_functions, scripts can use extra functions for testing MSE itself */
+	CLISetInterface(const SetP& set, bool quiet = false, bool test_functions = false);
 	~CLISetInterface();
 	
 	void run_interactive();
+	/// Serve requests from clients connecting to a local socket
+	/** Each connection is handled like run_interactive in raw mode, by a separate worker process
+	 *  that starts out with everything that is already loaded, so the set and packages stay warm.
+	 *  Up to one connection per CPU is served at the same time.
+	 *
+	 *  The workers are started with fork(), so no threads other than the main thread may be running
+	 *  when this is called, and this process must not start any while serving.
+	 *  Workers themselves can start threads as usual.
+	 *  Scripts run before serving only start threads for writing images, ExportImageWriter::finish stops those.
+	 */
+	void run_server(String const& socket_path);
 	bool run_script(ScriptP const& script);
 	bool run_script_string(String const& code, bool multiline = false);
 	bool run_script_file(String const& filename);
   protected:
 	virtual void onAction(const Action&, bool) {}
+	virtual bool listensTo(const Action&) const { return false; }
 	virtual void onChangeSet();
 	virtual void onBeforeChangeSet();
   private:
 	bool quiet;    ///< Supress prompts and other non-vital stuff
 	bool running;  ///< Still running?
+	bool test_functions; ///< Define the functions for testing?
 	
 	void showWelcome();
 	void showUsage();
 	void handleCommand(const String& command);
+	void simulatePacks(const String& arg);
+	void exportSet(const String& arg);
+	void printSet(const String& arg);
 	#if USE_SCRIPT_PROFILING
 		void showProfilingStats(const FunctionProfile& parent, int level = 0);
+		void showProfilingStages(const FunctionProfile& root);
+		void profileCommand(const String& arg);
 	#endif
 	
 	/// our own context, when no set is loaded
 	Context& getContext();
 	Context* our_context;
 	size_t scope;
+	/// Open the scope for the variables of the user, it contains the functions for testing
+	void openScope();
 	
 	// export info, so we can write files
 	ExportInfo ei;
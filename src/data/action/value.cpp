@@ -44,6 +44,19 @@ void SimpleValueAction::perform(bool to_undo) {
 	valueP->onAction(*this, to_undo); // notify value
 }
 
+/// Rough estimate of the memory used by a value
+static size_t value_memory_usage(const ScriptValueP& value) {
+	if (value && value->type() == SCRIPT_STRING) {
+		return value->toString().size() * sizeof(Char);
+	} else {
+		return 0;
+	}
+}
+
+size_t SimpleValueAction::memoryUsage() const {
+	return sizeof(*this) + value_memory_usage(new_value);
+}
+
 bool SimpleValueAction::merge(const Action& action) {
 	if (!allow_merge) return false;
 	TYPE_CASE(action, SimpleValueAction) {
@@ -70,33 +83,85 @@ TextValueAction::TextValueAction(const TextValueP& value, size_t start, size_t e
 	: SimpleValueAction(value, new_value)
 	, selection_start(start), selection_end(end), new_selection_end(new_end)
 	, name(name)
+	, delta_start(0), delta_length(0)
 {}
 
 String TextValueAction::getName(bool to_undo) const { return name; }
 
 void TextValueAction::perform(bool to_undo) {
 	swap(selection_end, new_selection_end);
-	SimpleValueAction::perform(to_undo);
+	if (new_value) {
+		SimpleValueAction::perform(to_undo);
+		performed_value = value().value;
+	} else {
+		ValueAction::perform(to_undo);
+		String val = value().value->toString();
+		// the value should be the one the delta was made for, but don't index outside it if it is not
+		delta_start  = min(delta_start,  val.size());
+		delta_length = min(delta_length, val.size() - delta_start);
+		String replaced = val.substr(delta_start, delta_length);
+		value().value = to_script(applyDelta(val));
+		delta_length = delta_text.size();
+		delta_text   = replaced;
+		value().onAction(*this, to_undo); // notify value
+	}
+}
+
+String TextValueAction::applyDelta(const String& val) const {
+	size_t start = min(delta_start, val.size());
+	size_t end   = min(delta_start + delta_length, val.size());
+	return val.substr(0, start) + delta_text + val.substr(end);
 }
 
 bool TextValueAction::merge(const Action& action) {
 	TYPE_CASE(action, TextValueAction) {
-		if (&action.value() == &value() && action.name == name) {
-			if (action.selection_start == selection_end) {
-				// adjacent edits, keep old value of this, it is older
+		if (&action.value() == &value() && action.name == name && action.new_value) {
+			bool adjacent_edits      = action.selection_start == selection_end;
+			bool adjacent_backspaces = action.new_selection_end == selection_start && name == _ACTION_("backspace");
+			if (!adjacent_edits && !adjacent_backspaces) return false;
+			if (!new_value) {
+				// the delta is relative to the value before the other action, which that action still has
+				new_value = to_script(applyDelta(action.new_value->toString()));
+			}
+			performed_value = value().value; // the other action has been performed
+			if (adjacent_edits) {
+				// keep old value of this, it is older
 				selection_end = action.selection_end;
-				return true;
-			} else if (action.new_selection_end == selection_start && name == _ACTION_("backspace")) {
-				// adjacent backspaces
+			} else {
 				selection_start = action.selection_start;
 				selection_end   = action.selection_end;
-				return true;
 			}
+			return true;
 		}
 	}
 	return false;
 }
 
+void TextValueAction::compact() {
+	if (!new_value || !performed_value) return; // already compact
+	// the value itself may have been changed already by the action on top of this one
+	ScriptValueP current = performed_value;
+	performed_value = ScriptValueP();
+	// only plain strings, a delta would lose the 'default' mark
+	if (current->type() != SCRIPT_STRING || is_default(current))     return;
+	if (new_value->type() != SCRIPT_STRING || is_default(new_value)) return;
+	// find the part that differs
+	String now   = current->toString();
+	String other = new_value->toString();
+	size_t size  = min(now.size(), other.size());
+	size_t start = 0, end = 0;
+	while (start < size && now.GetChar(start) == other.GetChar(start)) ++start;
+	while (end < size - start && now.GetChar(now.size() - end - 1) == other.GetChar(other.size() - end - 1)) ++end;
+	delta_start  = start;
+	delta_length = now.size() - start - end;
+	delta_text   = other.substr(start, other.size() - start - end);
+	new_value    = ScriptValueP();
+}
+
+size_t TextValueAction::memoryUsage() const {
+	return sizeof(*this) + (name.size() + delta_text.size()) * sizeof(Char) + value_memory_usage(new_value);
+}
+
 TextValue& TextValueAction::value() const {
 	return static_cast<TextValue&>(*valueP);
 }
@@ -192,6 +257,34 @@ void TextToggleReminderAction::perform(bool to_undo) {
 }
 
 
+// ----------------------------------------------------------------------------- : Multiple values
+
+MultipleValueAction::~MultipleValueAction() {
+	FOR_EACH(a, actions) delete a;
+}
+
+void MultipleValueAction::add(ValueAction* action) {
+	if (action) actions.push_back(action);
+}
+
+String MultipleValueAction::getName(bool to_undo) const {
+	return name;
+}
+
+void MultipleValueAction::perform(bool to_undo) {
+	if (to_undo) {
+		FOR_EACH_REVERSE(a, actions) a->perform(true);
+	} else {
+		FOR_EACH(a, actions) a->perform(false);
+	}
+}
+
+size_t MultipleValueAction::memoryUsage() const {
+	size_t size = sizeof(*this);
+	FOR_EACH_CONST(a, actions) size += a->memoryUsage();
+	return size;
+}
+
 // ----------------------------------------------------------------------------- : Event
 
 String ScriptValueEvent::getName(bool) const {
@@ -28,6 +28,8 @@ DECLARE_POINTER_TYPE(Style);
 typedef Value TextValue;
 typedef ValueP TextValueP;
 DECLARE_POINTER_TYPE(MultipleChoiceValue);
+class ValueAction;
+DECLARE_TYPEOF_COLLECTION(ValueAction*);
 
 // ----------------------------------------------------------------------------- : ValueAction (based class)
 
@@ -61,6 +63,7 @@ class SimpleValueAction : public ValueAction {
 	
 	virtual void perform(bool to_undo);
 	virtual bool merge(const Action& action);
+	virtual size_t memoryUsage() const;
 	
   protected:
 	ScriptValueP new_value;
@@ -94,16 +97,26 @@ class TextValueAction : public SimpleValueAction {
 	virtual String getName(bool to_undo) const;
 	virtual void perform(bool to_undo);
 	virtual bool merge(const Action& action);
+	virtual void compact();
+	virtual size_t memoryUsage() const;
 	
+	/// The new value, only available before the action is performed
 	inline String newValue() const { return new_value->toString(); }
 	
 	/// The modified selection
 	size_t selection_start, selection_end;
   private:
 	inline TextValue& value() const;
+	/// Apply the delta to a string
+	String applyDelta(const String& val) const;
 	
 	size_t new_selection_end;
 	String name;
+	ScriptValueP performed_value; ///< The value this action set when it was last performed, compact() compares it with new_value
+	// After compact() the action no longer stores the whole other value (new_value is null).
+	// Instead performing it replaces the characters [delta_start, delta_start + delta_length) with delta_text.
+	size_t delta_start, delta_length;
+	String delta_text;
 };
 
 /// Action for toggling some formating tag on or off in some range
@@ -130,6 +143,31 @@ class TextToggleReminderAction : public ValueAction {
 };
 
 
+// ----------------------------------------------------------------------------- : Multiple values
+
+/// An action that changes many values at once
+/** Scripts are updated once for all changes together, and listeners only see this action,
+ *  not the individual ValueActions.
+ *  Can only be used for set and card values, not for the fake values of keywords.
+ */
+class MultipleValueAction : public Action {
+  public:
+	inline MultipleValueAction(const String& name) : name(name) {}
+	~MultipleValueAction();
+	
+	/// Add an action, this action takes ownership
+	/** Must be done before the action is performed */
+	void add(ValueAction* action);
+	
+	virtual String getName(bool to_undo) const;
+	virtual void perform(bool to_undo);
+	virtual size_t memoryUsage() const;
+	
+	vector<ValueAction*> actions; ///< The individual changes, in the order they are performed
+  private:
+	String name;
+};
+
 // ----------------------------------------------------------------------------- : Event
 
 /// Notification that a script caused a value to change
@@ -12,6 +12,9 @@
 #include <data/set.hpp>
 #include <data/field.hpp>
 #include <util/io/package_manager.hpp>
+#include <util/error.hpp>
+#include <script/profiler.hpp>
+#include <wx/wfstream.h>
 
 // ----------------------------------------------------------------------------- : Export template, basics
 
@@ -48,6 +51,129 @@ IMPLEMENT_REFLECTION(ExportTemplate) {
 	REFLECT(script);
 }
 
+// ----------------------------------------------------------------------------- : ExportImageWriter
+
+DECLARE_TYPEOF_COLLECTION(String);
+
+class ExportImageWriterThread : public wxThread {
+  public:
+	ExportImageWriterThread(ExportImageWriter& parent) : wxThread(wxTHREAD_JOINABLE), parent(parent) {}
+	virtual ExitCode Entry();
+  private:
+	ExportImageWriter& parent;
+};
+
+wxThread::ExitCode ExportImageWriterThread::Entry() {
+	PROFILER_THREAD;
+	wxMutexLocker lock(parent.mutex);
+	while (!parent.jobs.empty()) {
+		// take a job, afterwards this thread has the only reference to the image
+		ExportImageWriter::Job job = parent.jobs.front();
+		parent.jobs.pop_front();
+		// encode it without holding the lock
+		// wxLog must not be used from this thread, so the handler is not verbose, finish() reports failures instead.
+		parent.mutex.Unlock();
+		bool ok = job.handler->SaveFile(&job.image, *job.stream, false)
+		       && job.stream->GetLastError() == wxSTREAM_NO_ERROR;
+		job.image  = Image();
+		job.stream = OutputStreamP(); // closes the file
+		parent.mutex.Lock();
+		if (!ok) parent.failed.push_back(String(job.filename.c_str()));
+		--parent.pending;
+		parent.completed.Broadcast();
+	}
+	// no more jobs
+	--parent.workers;
+	parent.completed.Broadcast();
+	return 0;
+}
+
+ExportImageWriter::ExportImageWriter()
+	: completed(mutex), pending(0), workers(0)
+{}
+
+ExportImageWriter::~ExportImageWriter() {
+	{
+		wxMutexLocker lock(mutex);
+		waitForJobs();
+	}
+	joinWorkers();
+}
+
+void ExportImageWriter::write(const Image& image, const String& filename, int type) {
+	// open the file in this thread, wx reports it if that fails
+	wxImageHandler* handler = wxImage::FindHandler((wxBitmapType)type);
+	OutputStreamP stream(new wxFileOutputStream(filename));
+	wxMutexLocker lock(mutex);
+	if (!handler || !stream->IsOk()) {
+		failed.push_back(filename);
+		return;
+	}
+	// copy the image and the filename, wxImage and wxString reference counts are not thread safe
+	Job job;
+	job.image    = image.Copy();
+	job.image.SetOption(wxIMAGE_OPTION_FILENAME, wxFileName(filename).GetName()); // as wxImage::SaveFile does
+	job.filename = String(filename.c_str());
+	job.handler  = handler;
+	job.stream   = stream;
+	jobs.push_back(job);
+	++pending;
+	// start a worker if all are busy
+	if (workers < max(1, wxThread::GetCPUCount()) && workers < pending) {
+		ExportImageWriterThread* thread = new ExportImageWriterThread(*this);
+		if (thread->Create() == wxTHREAD_NO_ERROR && thread->Run() == wxTHREAD_NO_ERROR) {
+			++workers;
+			threads.push_back(thread);
+		} else {
+			delete thread;
+			if (workers == 0) {
+				// no threads available, write the image in this thread
+				jobs.pop_back();
+				--pending;
+				if (!image.SaveFile(*stream, (wxBitmapType)type)) failed.push_back(filename);
+			}
+		}
+	}
+}
+
+void ExportImageWriter::waitForJobs(int max_pending) {
+	while (pending > max_pending) completed.Wait();
+}
+
+void ExportImageWriter::limit(int max_pending) {
+	wxMutexLocker lock(mutex);
+	waitForJobs(max_pending);
+}
+
+void ExportImageWriter::joinWorkers() {
+	// without jobs the workers stop by themselves, but they may still be running
+	vector<wxThread*> to_join;
+	{
+		wxMutexLocker lock(mutex);
+		to_join.swap(threads);
+	}
+	for (size_t i = 0 ; i < to_join.size() ; ++i) {
+		to_join[i]->Wait();
+		delete to_join[i];
+	}
+}
+
+void ExportImageWriter::finish() {
+	vector<String> failed_files;
+	{
+		wxMutexLocker lock(mutex);
+		waitForJobs();
+		failed_files.swap(failed);
+	}
+	joinWorkers();
+	if (failed_files.empty()) return;
+	String message = _("Unable to write image file:");
+	FOR_EACH(f, failed_files) {
+		message += _("\n  ") + f;
+	}
+	throw Error(message);
+}
+
 // ----------------------------------------------------------------------------- : ExportInfo
 
 IMPLEMENT_DYNAMIC_ARG(ExportInfo*, export_info, nullptr);
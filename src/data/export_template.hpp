@@ -12,6 +12,8 @@
 #include <util/prec.hpp>
 #include <util/io/package.hpp>
 #include <script/scriptable.hpp>
+#include <wx/thread.h>
+#include <deque>
 
 DECLARE_POINTER_TYPE(Game);
 DECLARE_POINTER_TYPE(Set);
@@ -19,6 +21,7 @@ DECLARE_POINTER_TYPE(Field);
 DECLARE_POINTER_TYPE(Style);
 DECLARE_POINTER_TYPE(ExportTemplate);
 DECLARE_POINTER_TYPE(Package);
+class ExportImageWriterThread;
 
 // ----------------------------------------------------------------------------- : ExportTemplate
 
@@ -46,6 +49,54 @@ class ExportTemplate : public Packaged {
 	DECLARE_REFLECTION();
 };
 
+// ----------------------------------------------------------------------------- : ExportImageWriter
+
+/// Writes the images of an export to files, using a pool of worker threads
+/** Images must be rendered in the main thread, but encoding and writing them can happen
+ *  while the export script continues.
+ */
+class ExportImageWriter {
+  public:
+	ExportImageWriter();
+	/// Waits until all images are written, ignoring errors
+	~ExportImageWriter();
+	
+	/// Write an image to a file in another thread, type is a wxBitmapType
+	void write(const Image& image, const String& filename, int type);
+	/// Wait until all images are written, and all worker threads have stopped
+	/** Throws an error naming each file that could not be written */
+	void finish();
+	/// Wait until at most max_pending images are still waiting to be written
+	/** Used to bound the memory used by the queued images */
+	void limit(int max_pending);
+	
+  private:
+	/// A single image to write
+	struct Job {
+		Image           image;
+		String          filename;
+		wxImageHandler* handler;  ///< Handler for the image type
+		OutputStreamP   stream;   ///< The file, opened by the main thread
+	};
+	wxMutex           mutex;       ///< Guards all members below
+	wxCondition       completed;   ///< Signaled when a job is completed or a worker stops
+	deque<Job>        jobs;        ///< Jobs on which work hasn't started
+	int               pending;     ///< Jobs that are not completed yet
+	int               workers;     ///< Number of running worker threads
+	vector<wxThread*> threads;     ///< All worker threads that have not been joined yet
+	vector<String>    failed;      ///< Files that could not be written
+	friend class ExportImageWriterThread;
+	
+	/// Wait until there are at most max_pending pending jobs. The mutex must be locked
+	void waitForJobs(int max_pending = 0);
+	/// Wait until all worker threads are gone. The mutex must not be locked, and there must be no pending jobs
+	void joinWorkers();
+};
+
+/// The wxBitmapType to use for writing an image file, based on its extension
+/** Returns wxBITMAP_TYPE_INVALID if the extension is not known */
+int image_type_for_file(const String& filename);
+
 // ----------------------------------------------------------------------------- : ExportInfo
 
 /// Information that can be used by export functions
@@ -60,6 +111,7 @@ struct ExportInfo {
 	String             directory_absolute; ///< The absolute path of the directory
 	map<String,wxSize> exported_images;	   ///< Images (from symbol font) already exported, and their size
 	bool               allow_writes_outside; ///< Can files outside the directory be written to?
+	ExportImageWriter  image_writer;       ///< Writes images in the background
 };
 
 DECLARE_DYNAMIC_ARG(ExportInfo*, export_info);
@@ -452,6 +452,8 @@ String KeywordDatabase::expand(const String& text,
 		//  - 'A' = reminder text in default state, shown
 		const char default_expand_type = 'a';
 		char expand_type = default_expand_type;
+		// positions in tagged, shared by all keywords tried on it, built when first needed
+		scoped_ptr<TaggedPositions> positions;
 		
 		for (size_t i = 0 ; i < tagged.size() ;) {
 			Char c = tagged.GetChar(i);
@@ -459,10 +461,12 @@ String KeywordDatabase::expand(const String& text,
 			if (c == _('<')) {
 				if (is_substr(tagged, i, _("<kw-")) && i + 4 < tagged.size()) {
 					expand_type = tagged.GetChar(i + 4); // <kw-?>
-					tagged = tagged.erase(i, skip_tag(tagged,i)-i); // remove the tag from the string
+					tagged.erase(i, skip_tag(tagged,i)-i); // remove the tag from the string
+					positions.reset();
 				} else if (is_substr(tagged, i, _("</kw-"))) {
 					expand_type = default_expand_type;
-					tagged = tagged.erase(i, skip_tag(tagged,i)-i); // remove the tag from the string
+					tagged.erase(i, skip_tag(tagged,i)-i); // remove the tag from the string
+					positions.reset();
 				} else if (is_substr(tagged, i, _("<atom"))) {
 					i = match_close_tag_end(tagged, i); // skip <atom>s
 				} else {
@@ -503,7 +507,8 @@ String KeywordDatabase::expand(const String& text,
 							continue; // already seen this keyword
 						}
 						// we have found a possible match, for a keyword which we have not seen before
-						if (tryExpand(*kw, i, tagged, untagged, result, expand_type,
+						if (!positions) positions.reset(new TaggedPositions(tagged));
+						if (tryExpand(*kw, i, tagged, *positions, untagged, result, expand_type,
 						              match_condition, expand_default, combine_script, ctx,
 						              stat, stat_key))
 						{
@@ -528,6 +533,7 @@ String KeywordDatabase::expand(const String& text,
 bool KeywordDatabase::tryExpand(const Keyword& kw,
                                 size_t expand_type_known_upto,
                                 String& tagged,
+                                const TaggedPositions& positions,
                                 String& untagged,
                                 String& result,
                                 char expand_type,
@@ -546,8 +552,8 @@ bool KeywordDatabase::tryExpand(const Keyword& kw,
 	// Find match position
 	size_t start_u = match.position();
 	size_t len_u   = match.length();
-	size_t start = untagged_to_index(tagged, start_u, true),
-	       end   = untagged_to_index(tagged, start_u + len_u, false);
+	size_t start = positions.untaggedToIndex(start_u, true),
+	       end   = positions.untaggedToIndex(start_u + len_u, false);
 	if (start == end) return false; // don't match empty keywords
 	
 	// a part of tagged has not been searched for <kw- tags
@@ -584,7 +590,7 @@ bool KeywordDatabase::tryExpand(const Keyword& kw,
 		size_t part_len_u   = match.length((int)submatch);
 		size_t part_end_u   = part_start_u + part_len_u;
 		// note: start_u can be (uint)-1 when part_len_u == 0
-		size_t part_end = part_len_u > 0 ? untagged_to_index(tagged, part_end_u, false) : part_start;
+		size_t part_end = part_len_u > 0 ? positions.untaggedToIndex(part_end_u, false) : part_start;
 		String part(tagged, part_start, part_end - part_start);
 		// strip left over </kw tags
 		part = remove_tag(part,_("</kw-"));
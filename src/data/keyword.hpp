@@ -19,6 +19,7 @@ DECLARE_POINTER_TYPE(KeywordMode);
 DECLARE_POINTER_TYPE(Keyword);
 DECLARE_POINTER_TYPE(ParamReferenceType);
 class KeywordTrie;
+class TaggedPositions;
 class Value;
 
 // ----------------------------------------------------------------------------- : Keyword parameters
@@ -173,8 +174,9 @@ class KeywordDatabase {
 	 *    - add the result to out
 	 *    - advance the tagged and untagged string by dropping a part from the front
 	 *    - return true
+	 *  positions must be the TaggedPositions of tagged.
 	 */
-	bool tryExpand(const Keyword& kw, size_t pos, String& tagged, String& untagged, String& out, char expand_type,
+	bool tryExpand(const Keyword& kw, size_t pos, String& tagged, const TaggedPositions& positions, String& untagged, String& out, char expand_type,
 	               const ScriptValueP& match_condition, const ScriptValueP& expand_default, const ScriptValueP& combine_script, Context& ctx,
 	               KeywordUsageStatistics* stat, Value* stat_key) const;
 };
@@ -11,13 +11,25 @@
 #include <data/set.hpp>
 #include <data/game.hpp>
 #include <data/card.hpp>
+#include <util/atomic.hpp>
+#include <script/profiler.hpp>
+#include <wx/thread.h>
 #include <queue>
 using boost::indeterminate;
 
+class PackSimulationWorker;
+class PackSimulationThread;
+
 DECLARE_TYPEOF_COLLECTION(PackTypeP);
 DECLARE_TYPEOF_COLLECTION(PackItemP);
 DECLARE_TYPEOF_COLLECTION(CardP);
+DECLARE_TYPEOF_COLLECTION(PackInstance*);
+DECLARE_TYPEOF_COLLECTION(PackSimulationWorker*);
+DECLARE_TYPEOF_COLLECTION(PackSimulationThread*);
+DECLARE_TYPEOF_COLLECTION(size_t);
+DECLARE_TYPEOF_COLLECTION(PackTypeStatistics);
 DECLARE_TYPEOF_CONST(map<String COMMA PackInstanceP>);
+DECLARE_TYPEOF(map<String COMMA PackInstanceP>);
 
 // ----------------------------------------------------------------------------- : PackType
 
@@ -151,6 +163,26 @@ PackInstance::PackInstance(const PackType& pack_type, PackGenerator& parent)
 	}
 }
 
+PackInstance::PackInstance(const PackInstance& that, PackGenerator& parent)
+	: pack_type(that.pack_type)
+	, parent(parent)
+	, depth(that.depth)
+	, cards(that.cards)
+	, total_weight(that.total_weight)
+	, requested_copies(0)
+	, card_copies(0)
+	, expected_copies(that.expected_copies)
+{}
+
+void PackInstance::count_card_hits(bool count) {
+	card_hits.clear();
+	if (count) card_hits.resize(cards.size(), 0);
+}
+
+void PackInstance::reset_order() {
+	shuffle_order.clear(); // generate() starts again from the identity order
+}
+
 void PackInstance::expect_copy(double copies) {
 	this->expected_copies += copies;
 	// propagate
@@ -225,6 +257,20 @@ void weighted_equal_divide(vector<WeightedItem>& items, int total) {
 	}
 }
 
+void PackInstance::pick(vector<CardP>* out, size_t i, size_t copies) {
+	if (out) out->insert(out->end(), copies, cards[i]);
+	if (!card_hits.empty()) card_hits[i] += copies;
+}
+
+void PackInstance::pick_all(vector<CardP>* out, size_t copies) {
+	for (size_t i = 0 ; i < copies ; ++i) {
+		if (out) out->insert(out->end(), cards.begin(), cards.end());
+	}
+	if (!card_hits.empty()) {
+		FOR_EACH(h, card_hits) h += copies;
+	}
+}
+
 void PackInstance::generate(vector<CardP>* out) {
 	card_copies = 0;
 	if (requested_copies == 0) return;
@@ -246,14 +292,21 @@ void PackInstance::generate(vector<CardP>* out) {
 		}
 		card_copies += requested_copies;
 		// NOTE: there is no way to pick items without replacement
-		if (out && !cards.empty()) {
+		if (picking(out) && !cards.empty()) {
 			// to prevent us from being too predictable for small sets, periodically reshuffle
+			// we shuffle the indices instead of the cards, so card_hits stays in the same order
+			if (shuffle_order.size() != cards.size()) {
+				shuffle_order.resize(cards.size());
+				for (size_t i = 0 ; i < cards.size() ; ++i) shuffle_order[i] = i;
+			}
 			RandomRange<boost::mt19937> gen_range(parent.gen);
 			int max_per_batch = ((int)cards.size() + 1) / 2;
 			int rem = (int)requested_copies;
 			while (rem > 0) {
-				random_shuffle(cards.begin(), cards.end(), gen_range);
-				out->insert(out->end(), cards.begin(), cards.begin() + min(rem, max_per_batch));
+				random_shuffle(shuffle_order.begin(), shuffle_order.end(), gen_range);
+				for (int i = 0 ; i < min(rem, max_per_batch) ; ++i) {
+					pick(out, shuffle_order[i]);
+				}
 				rem -= max_per_batch;
 			}
 		}
@@ -293,17 +346,15 @@ void PackInstance::generate(vector<CardP>* out) {
 			// 3b. pick some cards
 			int new_card_copies = weighted_items.back().count;
 			card_copies += new_card_copies;
-			if (out && !cards.empty()) {
+			if (picking(out) && !cards.empty()) {
 				int div = new_card_copies / (int)cards.size();
 				int rem = new_card_copies % (int)cards.size();
 				// some copies of all cards
-				for (int i = 0 ; i < div ; ++i) {
-					out->insert(out->end(), cards.begin(), cards.end());
-				}
+				pick_all(out, div);
 				// pick the remainder at random
 				for (int i = 0 ; i < rem ; ++i) {
 					int nr = parent.gen() % cards.size();
-					out->push_back(cards.at(nr));
+					pick(out, nr);
 				}
 			}
 		}
@@ -312,7 +363,7 @@ void PackInstance::generate(vector<CardP>* out) {
 		if (!cards.empty()) {
 			// there is a card, pick it
 			card_copies += requested_copies;
-			if (out) out->insert(out->end(), requested_copies, cards.front());
+			if (picking(out)) pick(out, 0, requested_copies);
 		} else {
 			// pick first nonempty item
 			FOR_EACH_CONST(item, pack_type.items) {
@@ -329,11 +380,7 @@ void PackInstance::generate(vector<CardP>* out) {
 
 void PackInstance::generate_all(vector<CardP>* out, size_t copies) {
 	card_copies += copies * cards.size();
-	if (out) {
-		for (size_t i = 0 ; i < copies ; ++i) {
-			out->insert(out->end(), cards.begin(), cards.end());
-		}
-	}
+	if (picking(out)) pick_all(out, copies);
 	// and all items
 	FOR_EACH_CONST(item, pack_type.items) {
 		PackInstance& i = parent.get(item->name);
@@ -346,10 +393,7 @@ void PackInstance::generate_one_random(vector<CardP>* out) {
 	if (r < cards.size()) {
 		// pick a card
 		card_copies++;
-		if (out) {
-			int i = (int)r;
-			out->push_back(cards[i]);
-		}
+		if (picking(out)) pick(out, (size_t)r);
 	} else {
 		// pick an item
 		r -= cards.size();
@@ -381,6 +425,33 @@ void PackGenerator::reset(const SetP& set, int seed) {
 }
 void PackGenerator::reset(int seed) {
 	gen.seed((unsigned)seed);
+	// the shuffled order would otherwise carry over from earlier packs
+	FOR_EACH(i, instances) {
+		i.second->reset_order();
+	}
+}
+void PackGenerator::reset(const PackGenerator& that, int seed) {
+	reset(that.set, seed);
+	max_depth = that.max_depth;
+	FOR_EACH_CONST(i, that.instances) {
+		instances[i.first] = PackInstanceP(new PackInstance(*i.second, *this));
+	}
+}
+
+void PackGenerator::instantiate_all() {
+	if (!set) return;
+	FOR_EACH_CONST(type, set->game->pack_types) get(type);
+	FOR_EACH_CONST(type, set->pack_types)       get(type);
+}
+
+void PackGenerator::get_instances(vector<PackInstance*>& out) {
+	for (int depth = max_depth ; depth >= 0 ; --depth) {
+		FOR_EACH(i,instances) {
+			if (i.second->get_depth() == depth) {
+				out.push_back(i.second.get());
+			}
+		}
+	}
 }
 
 PackInstance& PackGenerator::get(const String& name) {
@@ -444,3 +515,196 @@ void PackGenerator::update_card_counts() {
 		}
 	}
 }
+
+// ----------------------------------------------------------------------------- : Simulation
+
+/// Number of packs generated with a single seed
+const size_t packs_per_chunk = 4096;
+
+/// Seed for the given chunk of a simulation
+/** Seeds of consecutive chunks are scrambled, so the random streams are unrelated */
+unsigned chunk_seed(int seed, size_t chunk) {
+	unsigned x = (unsigned)seed + 0x9E3779B9u * (unsigned)(chunk + 1);
+	x ^= x >> 16; x *= 0x85EBCA6Bu;
+	x ^= x >> 13; x *= 0xC2B2AE35u;
+	x ^= x >> 16;
+	return x;
+}
+
+/// Generates chunks of packs for a simulation, until there are no chunks left
+/** Each worker has its own generator, so workers can run in parallel */
+class PackSimulationWorker {
+  public:
+	PackSimulationWorker(PackSimulation& sim, size_t packs, int seed, AtomicInt& next_chunk)
+		: sim(sim), packs(packs), seed(seed), next_chunk(next_chunk)
+	{
+		generator.reset(sim.prototype, seed);
+	}
+	
+	/// Generate chunks, store errors instead of throwing them
+	void run() {
+		try {
+			work();
+		} catch (const Error& e) {
+			error = e.what();
+		} catch (...) {
+			error = _("Unexpected error in pack simulation");
+		}
+	}
+	
+	PackGenerator           generator;
+	vector<vector<size_t> > distributions; ///< Distributions of the instances with cards, in get_instances order
+	String                  error;
+	
+  private:
+	PackSimulation& sim;
+	size_t          packs;
+	int             seed;
+	AtomicInt&      next_chunk;
+	
+	void work() {
+		// the instances that we need, in order
+		vector<PackInstance*> instances;
+		generator.get_instances(instances);
+		PackInstance& pack = generator.get(sim.pack_name);
+		vector<PackInstance*> leaves;
+		FOR_EACH(i, instances) {
+			if (i->has_cards()) {
+				i->count_card_hits(true);
+				leaves.push_back(i);
+			}
+		}
+		distributions.resize(leaves.size());
+		// generate
+		size_t chunks = (packs + packs_per_chunk - 1) / packs_per_chunk;
+		while (true) {
+			size_t chunk = (size_t)(AtomicIntEquiv)(++next_chunk) - 1;
+			if (chunk >= chunks) break;
+			generator.reset(chunk_seed(seed, chunk));
+			size_t end = min(packs, (chunk + 1) * packs_per_chunk);
+			for (size_t p = chunk * packs_per_chunk ; p < end ; ++p) {
+				pack.request_copy();
+				FOR_EACH(i, instances) {
+					i->generate(nullptr);
+				}
+				for (size_t j = 0 ; j < leaves.size() ; ++j) {
+					vector<size_t>& dist = distributions[j];
+					size_t copies = leaves[j]->get_card_copies();
+					if (copies >= dist.size()) dist.resize(copies + 1, 0);
+					dist[copies]++;
+				}
+			}
+		}
+	}
+};
+
+/// Thread running a PackSimulationWorker
+class PackSimulationThread : public wxThread {
+  public:
+	PackSimulationThread(PackSimulationWorker& worker)
+		: wxThread(wxTHREAD_JOINABLE), worker(worker)
+	{}
+	virtual ExitCode Entry() {
+		PROFILER_THREAD;
+		worker.run();
+		return 0;
+	}
+  private:
+	PackSimulationWorker& worker;
+};
+
+PackSimulation::PackSimulation(const SetP& set, const String& pack_name)
+	: packs(0)
+	, set(set)
+	, pack_name(pack_name)
+{
+	// evaluate all the filters once, in this thread, the workers copy the prototype
+	prototype.reset(set, 0);
+	prototype.instantiate_all();
+	prototype.get(pack_name).expect_copy(1);
+}
+
+void PackSimulation::run(size_t packs, int seed, int threads) {
+	this->packs = packs;
+	card_counts.clear();
+	FOR_EACH_CONST(card, set->cards) {
+		card_counts.push_back(make_pair(card, (size_t)0));
+	}
+	pack_types.clear();
+	// more threads than chunks would be pointless
+	if (threads <= 0) threads = max(1, wxThread::GetCPUCount());
+	size_t chunks = (packs + packs_per_chunk - 1) / packs_per_chunk;
+	threads = (int)max((size_t)1, min((size_t)threads, chunks));
+	// create workers
+	AtomicInt next_chunk(0);
+	vector<PackSimulationWorker*> workers;
+	for (int i = 0 ; i < threads ; ++i) {
+		workers.push_back(new PackSimulationWorker(*this, packs, seed, next_chunk));
+	}
+	// start threads, the first worker runs in this thread
+	// if a thread can not be started, the other workers just take over its chunks
+	vector<PackSimulationThread*> running;
+	for (size_t i = 1 ; i < workers.size() ; ++i) {
+		PackSimulationThread* thread = new PackSimulationThread(*workers[i]);
+		if (thread->Create() == wxTHREAD_NO_ERROR && thread->Run() == wxTHREAD_NO_ERROR) {
+			running.push_back(thread);
+		} else {
+			delete thread;
+		}
+	}
+	workers[0]->run();
+	FOR_EACH(thread, running) {
+		thread->Wait();
+		delete thread;
+	}
+	// combine results
+	String error;
+	FOR_EACH(worker, workers) {
+		if (worker->error.empty()) {
+			add(worker->generator, worker->distributions);
+		} else {
+			error = worker->error;
+		}
+		delete worker;
+	}
+	if (!error.empty()) throw Error(error);
+}
+
+void PackSimulation::add(PackGenerator& generator, const vector<vector<size_t> >& distributions) {
+	// card positions in the set
+	map<const Card*,size_t> positions;
+	for (size_t i = 0 ; i < card_counts.size() ; ++i) {
+		positions.insert(make_pair(card_counts[i].first.get(), i));
+	}
+	vector<PackInstance*> instances;
+	generator.get_instances(instances);
+	size_t j = 0;
+	FOR_EACH(inst, instances) {
+		if (!inst->has_cards()) continue;
+		// card counts
+		const vector<CardP>&  cards = inst->get_cards();
+		const vector<size_t>& hits  = inst->get_card_hits();
+		for (size_t k = 0 ; k < cards.size() && k < hits.size() ; ++k) {
+			map<const Card*,size_t>::const_iterator it = positions.find(cards[k].get());
+			if (it != positions.end()) card_counts[it->second].second += hits[k];
+		}
+		// distribution per pack type
+		const String& name = inst->get_pack_type().name;
+		PackTypeStatistics* stats = nullptr;
+		FOR_EACH(s, pack_types) {
+			if (s.name == name) stats = &s;
+		}
+		if (!stats) {
+			pack_types.push_back(PackTypeStatistics());
+			stats = &pack_types.back();
+			stats->name = name;
+			stats->expected_copies = prototype.get(name).get_expected_copies();
+		}
+		const vector<size_t>& dist = distributions.at(j++);
+		if (stats->distribution.size() < dist.size()) stats->distribution.resize(dist.size(), 0);
+		for (size_t n = 0 ; n < dist.size() ; ++n) {
+			stats->distribution[n] += dist[n];
+			stats->total_copies    += n * dist[n];
+		}
+	}
+}
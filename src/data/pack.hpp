@@ -87,6 +87,8 @@ inline String type_name(const PackType&) {
 class PackInstance : public IntrusivePtrBase<PackInstance> {
   public:
 	PackInstance(const PackType& pack_type, PackGenerator& parent);
+	/// Copy an instance for use by another generator, the filter is not evaluated again
+	PackInstance(const PackInstance& that, PackGenerator& parent);
 	
 	/// Expect to pick this many copies from this pack, updates expected_copies
 	void expect_copy(double copies = 1);
@@ -104,6 +106,18 @@ class PackInstance : public IntrusivePtrBase<PackInstance> {
 	inline bool   has_cards()           const { return !cards.empty(); }
 	inline size_t get_card_copies()     const { return card_copies; }
 	inline double get_expected_copies() const { return expected_copies; }
+	inline const PackType&       get_pack_type() const { return pack_type; }
+	inline const vector<CardP>&  get_cards()     const { return cards; }
+	
+	/// Start or stop counting how often each card is picked by generate()
+	/** This also happens when generate() is called without an output vector */
+	void count_card_hits(bool count);
+	/// How often each card was picked, in the same order as get_cards()
+	inline const vector<size_t>& get_card_hits() const { return card_hits; }
+	
+	/// Forget the order of the cards used for SELECT_NO_REPLACE
+	/** Afterwards the cards that are generated only depend on the random generator */
+	void reset_order();
 	
   private:
 	const PackType& pack_type;
@@ -114,6 +128,15 @@ class PackInstance : public IntrusivePtrBase<PackInstance> {
 	size_t          requested_copies;  //< The requested number of copies of this pack
 	size_t          card_copies;       //< The number of cards that were chosen to come from this pack
 	double          expected_copies;
+	vector<size_t>  card_hits;         //< How often each card was picked, if we are counting
+	vector<size_t>  shuffle_order;     //< Order of the cards for SELECT_NO_REPLACE
+	
+	/// Are cards picked, either for output or for counting?
+	inline bool picking(vector<CardP>* out) const { return out || !card_hits.empty(); }
+	/// Pick some copies of the i-th card
+	void pick(vector<CardP>* out, size_t i, size_t copies = 1);
+	/// Pick some copies of all cards
+	void pick_all(vector<CardP>* out, size_t copies);
 	
 	/// Generate some copies of all cards and items
 	void generate_all(vector<CardP>* out, size_t copies);
@@ -126,7 +149,16 @@ class PackGenerator {
 	/// Reset the generator, possibly switching the set or reseeding
 	void reset(const SetP& set, int seed);
 	/// Reset the generator, but not the set
+	/** Also resets all state of the instances that affects which cards are generated */
 	void reset(int seed);
+	/// Reset the generator to a copy of another one, without evaluating the pack filters again
+	/** The instances of that generator are copied, the card counts are not */
+	void reset(const PackGenerator& that, int seed);
+	
+	/// Make sure there is a PackInstance for each PackType in the set and game
+	void instantiate_all();
+	/// All instances, in the order in which they should be generated (highest depth first)
+	void get_instances(vector<PackInstance*>& out);
 	
 	/// Find the PackInstance for the PackType with the given name
 	PackInstance& get(const String& name);
@@ -146,5 +178,46 @@ class PackGenerator {
 	int max_depth;
 };
 
+// ----------------------------------------------------------------------------- : Simulation
+
+/// Statistics for a single PackType from a simulation
+struct PackTypeStatistics {
+	PackTypeStatistics() : expected_copies(0), total_copies(0) {}
+	
+	String         name;            ///< Name of the pack type
+	double         expected_copies; ///< Expected number of cards per pack, as computed by expect_copy
+	size_t         total_copies;    ///< Total number of cards picked from this pack type
+	vector<size_t> distribution;    ///< distribution[n] = number of packs with n cards of this pack type
+};
+
+/// Generate a large number of packs, and gather statistics about them
+/** Generation is split into chunks of packs, each with its own random seed derived from the main seed.
+ *  The chunks are divided among worker threads, each with their own PackGenerator.
+ *  The results are independent of the number of threads.
+ *
+ *  The cards of the generated packs are not stored, only counted.
+ */
+class PackSimulation {
+  public:
+	PackSimulation(const SetP& set, const String& pack_name);
+	
+	/// Generate the given number of packs, using the given number of threads (0 = number of CPUs)
+	void run(size_t packs, int seed, int threads = 0);
+	
+	size_t                     packs;       ///< Number of packs generated
+	vector<pair<CardP,size_t> > card_counts; ///< Number of times each card was picked, in set order
+	vector<PackTypeStatistics> pack_types;  ///< Statistics of pack types that select cards
+	
+  private:
+	SetP          set;
+	String        pack_name;
+	PackGenerator prototype; ///< Generator with all instances, copied by the workers
+	
+	friend class PackSimulationWorker;
+	/// Add the results of a worker
+	void add(PackGenerator& generator, const vector<vector<size_t> >& distributions);
+};
+
+
 // ----------------------------------------------------------------------------- : EOF
 #endif
@@ -16,6 +16,7 @@
 #include <data/field.hpp>
 #include <data/field/text.hpp>    // for 0.2.7 fix
 #include <data/field/information.hpp>
+#include <data/settings.hpp>
 #include <util/tagged_string.hpp> // for 0.2.7 fix
 #include <util/order_cache.hpp>
 #include <util/delayed_index_maps.hpp>
@@ -24,6 +25,7 @@
 #include <wx/sstream.h>
 
 DECLARE_TYPEOF_COLLECTION(CardP);
+DECLARE_TYPEOF(map<pair<ScriptValueP COMMA ScriptValueP> COMMA OrderCacheP>);
 DECLARE_TYPEOF_NO_REV(IndexMap<FieldP COMMA ValueP>);
 
 // ----------------------------------------------------------------------------- : Set
@@ -31,7 +33,9 @@ DECLARE_TYPEOF_NO_REV(IndexMap<FieldP COMMA ValueP>);
 Set::Set()
 	: vcs (intrusive(new VCS()))
 	, script_manager(new SetScriptManager(*this))
-{}
+{
+	actions.setMemoryLimit((size_t)settings.undo_memory_limit * 1024 * 1024);
+}
 
 Set::Set(const GameP& game)
 	: game(game)
@@ -39,6 +43,7 @@ Set::Set(const GameP& game)
 	, script_manager(new SetScriptManager(*this))
 {
 	data.init(game->set_fields);
+	actions.setMemoryLimit((size_t)settings.undo_memory_limit * 1024 * 1024);
 }
 
 Set::Set(const StyleSheetP& stylesheet)
@@ -48,6 +53,7 @@ Set::Set(const StyleSheetP& stylesheet)
 	, script_manager(new SetScriptManager(*this))
 {
 	data.init(game->set_fields);
+	actions.setMemoryLimit((size_t)settings.undo_memory_limit * 1024 * 1024);
 }
 
 Set::~Set() {}
@@ -247,9 +253,18 @@ void reflect_set_info_get_member(GetMember& reflector, const IndexMap<FieldP, Va
 	REFLECT_NAMELESS(data);
 }
 
+/// Maximum number of different order_by/filter combinations to cache
+/** The caches are not cleared between script updates, so closures that are created anew
+ *  each time would otherwise keep adding entries.
+ */
+const size_t MAX_ORDER_CACHE_SIZE = 64;
+
 int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const ScriptValueP& filter) {
 	// TODO : Lock the map?
 	assert(order_by);
+	if (order_cache.size() >= MAX_ORDER_CACHE_SIZE && order_cache.find(make_pair(order_by,filter)) == order_cache.end()) {
+		order_cache.clear();
+	}
 	OrderCacheP& order = order_cache[make_pair(order_by,filter)];
 	if (!order) {
 		// 1. make a list of the order value for each card
@@ -273,15 +288,17 @@ int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const S
 }
 int Set::numberOfCards(const ScriptValueP& filter) {
 	if (!filter) return (int)cards.size();
-	map<ScriptValueP,int>::const_iterator it = filter_cache.find(filter);
-	if (it !=filter_cache.end()) {
-		return it->second;
+	map<ScriptValueP,set<const Card*> >::const_iterator it = filter_cache.find(filter);
+	if (it != filter_cache.end()) {
+		return (int)it->second.size();
 	} else {
-		int n = 0;
+		set<const Card*> kept;
 		FOR_EACH_CONST(c, cards) {
-			if (filter->eval(getContext(c))->toBool()) ++n;
+			if (filter->eval(getContext(c))->toBool()) kept.insert(c.get());
 		}
-		filter_cache.insert(make_pair(filter,n));
+		if (filter_cache.size() >= MAX_ORDER_CACHE_SIZE) filter_cache.clear();
+		int n = (int)kept.size();
+		filter_cache[filter].swap(kept);
 		return n;
 	}
 }
@@ -289,6 +306,36 @@ void Set::clearOrderCache() {
 	order_cache.clear();
 	filter_cache.clear();
 }
+void Set::updateOrderCache(const CardP& card) {
+	if (order_cache.empty() && filter_cache.empty()) return;
+	Context& ctx = getContext(card);
+	FOR_EACH(o, order_cache) {
+		if (!o.second) continue;
+		const ScriptValueP& order_by = o.first.first;
+		const ScriptValueP& filter   = o.first.second;
+		try {
+			String value = order_by->eval(ctx)->toString();
+			bool   keep  = !filter || filter->eval(ctx)->toBool();
+			if (!o.second->update(card, value, keep)) {
+				o.second = OrderCacheP(); // card not in the cache, rebuild when needed
+			}
+		} catch (const ScriptError&) {
+			o.second = OrderCacheP(); // the error will show up when the cache is rebuilt
+		}
+	}
+	for (map<ScriptValueP,set<const Card*> >::iterator it = filter_cache.begin() ; it != filter_cache.end() ; ) {
+		try {
+			if (it->first->eval(ctx)->toBool()) {
+				it->second.insert(card.get());
+			} else {
+				it->second.erase(card.get());
+			}
+			++it;
+		} catch (const ScriptError&) {
+			filter_cache.erase(it++);
+		}
+	}
+}
 
 // ----------------------------------------------------------------------------- : SetView
 
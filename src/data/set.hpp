@@ -106,6 +106,9 @@ class Set : public Packaged {
 	int numberOfCards(const ScriptValueP& filter);
 	/// Clear the order_cache used by positionOfCard
 	void clearOrderCache();
+	/// Update the order and filter caches after the values of a single card have changed
+	/** Only the given card is re-evaluated and moved, the rest of the cache stays valid */
+	void updateOrderCache(const CardP& card);
 	
 	virtual String typeName() const;
 	Version fileVersion() const;
@@ -127,8 +130,11 @@ class Set : public Packaged {
 	/// Object for executing scripts from the thumbnail thread
 	scoped_ptr<SetScriptContext> thumbnail_script_context;
 	/// Cache of cards ordered by some criterion
+	/** The caches are kept between script updates, the script manager calls updateOrderCache
+	 *  when a value that an order_by or filter script depends on changes.
+	 */
 	map<pair<ScriptValueP,ScriptValueP>,OrderCacheP> order_cache;
-	map<ScriptValueP,int>                            filter_cache;
+	map<ScriptValueP,set<const Card*> >              filter_cache;
 };
 
 inline String type_name(const Set&) {
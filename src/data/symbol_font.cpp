@@ -60,6 +60,11 @@ IMPLEMENT_REFLECTION(SymbolFont) {
 	REFLECT(insert_symbol_menu);
 }
 
+void SymbolFont::validate(Version ver) {
+	Packaged::validate(ver);
+	indexSymbols();
+}
+
 // ----------------------------------------------------------------------------- : SymbolInFont
 
 /// A symbol in a symbol font
@@ -97,8 +102,10 @@ class SymbolInFont : public IntrusivePtrBase<SymbolInFont> {
 	ScriptableImage  image;			///< The image for this symbol
 	double           img_size;		///< Font size used by the image
 	wxSize           actual_size;	///< Actual image size, only known after loading the image
-	/// Cached bitmaps for different sizes
-	map<double, Bitmap> bitmaps;
+	/// Cached bitmaps for different sizes, most recently used first
+	vector<pair<double,Bitmap> > bitmaps;
+	/// Maximum number of sizes to keep bitmaps for
+	static const size_t MAX_CACHED_BITMAPS = 8;
 	
 	DECLARE_REFLECTION();
 };
@@ -133,11 +140,19 @@ Image SymbolInFont::getImage(Package& pkg, double size) {
 }
 Bitmap SymbolInFont::getBitmap(Package& pkg, double size) {
 	// is this bitmap already loaded/generated?
-	Bitmap& bmp = bitmaps[size];
-	if (!bmp.Ok()) {
-		// generate image, convert to bitmap, store for later use
-		bmp = Bitmap(getImage(pkg, size));
+	for (size_t i = 0 ; i < bitmaps.size() ; ++i) {
+		if (bitmaps[i].first == size && bitmaps[i].second.Ok()) {
+			// move to the front, it is now the most recently used
+			rotate(bitmaps.begin(), bitmaps.begin() + i, bitmaps.begin() + i + 1);
+			return bitmaps.front().second;
+		}
+	}
+	// generate image, convert to bitmap, store for later use
+	Bitmap bmp(getImage(pkg, size));
+	if (bitmaps.size() >= MAX_CACHED_BITMAPS) {
+		bitmaps.pop_back(); // forget the least recently used size
 	}
+	bitmaps.insert(bitmaps.begin(), make_pair(size, bmp));
 	return bmp;
 }
 Bitmap SymbolInFont::getBitmap(Package& pkg, wxSize size) {
@@ -193,19 +208,51 @@ IMPLEMENT_REFLECTION(SymbolInFont) {
 
 // ----------------------------------------------------------------------------- : SymbolFont : splitting
 
+void SymbolFont::indexSymbols() {
+	symbols_by_first_char.clear();
+	symbols_any_char.clear();
+	// the characters that codes start with
+	FOR_EACH(sym, symbols) {
+		if (sym->code.empty()) continue;
+		const String& start = sym->regex ? sym->code_regex.literalPrefix() : sym->code;
+		if (!start.empty()) {
+			symbols_by_first_char[start.GetChar(0)];
+		}
+	}
+	// the candidates for each character, in the same order as the symbol list, so the first match still wins
+	FOR_EACH(sym, symbols) {
+		if (sym->code.empty()) continue;
+		const String& start = sym->regex ? sym->code_regex.literalPrefix() : sym->code;
+		if (start.empty()) {
+			symbols_any_char.push_back(sym);
+			for (map<Char, vector<SymbolInFontP> >::iterator it = symbols_by_first_char.begin() ; it != symbols_by_first_char.end() ; ++it) {
+				it->second.push_back(sym);
+			}
+		} else {
+			symbols_by_first_char[start.GetChar(0)].push_back(sym);
+		}
+	}
+}
+
+const vector<SymbolInFontP>& SymbolFont::candidateSymbols(Char c) const {
+	map<Char, vector<SymbolInFontP> >::const_iterator it = symbols_by_first_char.find(c);
+	return it != symbols_by_first_char.end() ? it->second : symbols_any_char;
+}
+
 void SymbolFont::split(const String& text, SplitSymbols& out) const {
 	// read a single symbol until we are done with the text
 	for (size_t pos = 0 ; pos < text.size() ; ) {
-		// check symbol list
-		FOR_EACH_CONST(sym, symbols) {
-			if (!sym->code.empty() && sym->enabled) {
+		// check the symbols that can start at this character
+		const vector<SymbolInFontP>& candidates = candidateSymbols(text.GetChar(pos));
+		FOR_EACH_CONST(sym, candidates) {
+			if (sym->enabled) {
 				if (sym->regex) {
 					if (sym->code_regex.empty()) {
 						sym->code_regex.assign(sym->code);
 					}
 					Regex::Results results;
-					if (sym->code_regex.matches(results,text.begin() + pos, text.end())
-							&& results.position() == 0 && results.length() > 0) { //Matches the regex
+					if (sym->code_regex.matchesAt(results,text.begin() + pos, text.end())
+							&& results.length() > 0) { //Matches the regex
 						if (sym->draw_text >= 0 && sym->draw_text < (int)results.size()) {
 							out.push_back(DrawableSymbol(
 											results.str(),
@@ -239,13 +286,14 @@ next_symbol:;
 size_t SymbolFont::recognizePrefix(const String& text, size_t start) const {
 	size_t pos;
 	for (pos = start ; pos < text.size() ; ) {
-		// check symbol list
-		FOR_EACH_CONST(sym, symbols) {
-			if (!sym->code.empty() && sym->enabled) {
+		// check the symbols that can start at this character
+		const vector<SymbolInFontP>& candidates = candidateSymbols(text.GetChar(pos));
+		FOR_EACH_CONST(sym, candidates) {
+			if (sym->enabled) {
 				if (sym->regex) {
 					Regex::Results results;
-					if (!sym->code_regex.empty() && sym->code_regex.matches(results,text.begin() + pos, text.end())
-							&& results.position() == 0 && results.length() > 0) { //Matches the regex
+					if (!sym->code_regex.empty() && sym->code_regex.matchesAt(results,text.begin() + pos, text.end())
+							&& results.length() > 0) { //Matches the regex
 						pos += results.length();
 						goto next_symbol;
 					}
@@ -93,6 +93,16 @@ class SymbolFont : public Packaged {
 	friend class SymbolInFont;
 	friend class InsertSymbolMenu;
 	vector<SymbolInFontP> symbols;	///< The individual symbols
+	
+	/// Symbols whose code can start with a given character, in the order of symbols
+	map<Char, vector<SymbolInFontP> > symbols_by_first_char;
+	/// Symbols whose code can start with any character (regexes without a literal prefix)
+	vector<SymbolInFontP>             symbols_any_char;
+	
+	/// Build symbols_by_first_char and symbols_any_char
+	void indexSymbols();
+	/// The symbols that could match at a position with the given character, in order
+	const vector<SymbolInFontP>& candidateSymbols(Char c) const;
 		
 	/// Find the default symbol
 	/** may return nullptr */
@@ -107,6 +117,9 @@ class SymbolFont : public Packaged {
 	/// The default size of symbols, including spacing
 	RealSize defaultSymbolSize(double font_size);
 	
+  protected:
+	virtual void validate(Version);
+	
 	DECLARE_REFLECTION();
 };
 
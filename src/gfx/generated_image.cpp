@@ -504,6 +504,14 @@ Image ImageValueToImage::generate(const Options& opt) const {
 	Image image;
 	if (!filename.empty()) {
 		InputStreamP image_file = opt.local_package->openIn(filename);
+		#if wxCHECK_VERSION(2,9,3)
+			if (opt.draft && opt.width > 0 && opt.height > 0) {
+				// let the image handler decode at a reduced size (for jpeg this uses DCT scaling),
+				// it halves the size while it is more than twice the requested size
+				image.SetOption(wxIMAGE_OPTION_MAX_WIDTH,  2 * opt.width);
+				image.SetOption(wxIMAGE_OPTION_MAX_HEIGHT, 2 * opt.height);
+			}
+		#endif
 		image.LoadFile(*image_file);
 	}
 	if (!image.Ok()) {
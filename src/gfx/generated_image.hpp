@@ -30,7 +30,7 @@ class GeneratedImage : public ScriptValue {
 	struct Options {
 		Options(int width = 0, int height = 0, Package* package = nullptr, Package* local_package = nullptr, PreserveAspect preserve_aspect = ASPECT_STRETCH, bool saturate = false)
 			: width(width), height(height), zoom(1.0), angle(0)
-			, preserve_aspect(preserve_aspect), saturate(saturate)
+			, preserve_aspect(preserve_aspect), saturate(saturate), draft(false)
 			, package(package), local_package(local_package)
 		{}
 		
@@ -40,6 +40,7 @@ class GeneratedImage : public ScriptValue {
 		Radians        angle;           ///< Angle to rotate image by afterwards
 		PreserveAspect preserve_aspect;
 		bool           saturate;
+		bool           draft;           ///< Is speed more important than quality? Then images may be decoded at a reduced resolution
 		Package* package;       ///< Package to load images from
 		Package* local_package; ///< Package to load symbols and ImageValue images from
 	};
@@ -386,6 +387,8 @@ class ImageValueToImage : public GeneratedImage {
 	virtual bool local() const { return true; }
 	
 	virtual String toCode() const;
+	/// The file in the local package the image is loaded from
+	inline const LocalFileName& getFilename() const { return filename; }
   private:
 	ImageValueToImage(const ImageValueToImage&); // copy ctor
 	LocalFileName filename;
@@ -28,6 +28,7 @@ DECLARE_TYPEOF_COLLECTION(FieldP);
 DECLARE_TYPEOF(map<int COMMA FieldP>);
 DECLARE_TYPEOF_NO_REV(IndexMap<FieldP COMMA StyleP>);
 DECLARE_TYPEOF_COLLECTION(CardListBase*);
+DECLARE_TYPEOF_COLLECTION(const Card*);
 
 // ----------------------------------------------------------------------------- : Events
 
@@ -76,9 +77,18 @@ struct Freezer{
 	~Freezer()                               { window->Thaw(); }
 };
 
+bool CardListBase::listensTo(const Action& action) const {
+	return is_action<CardListAction>(action)
+	    || is_action<ScriptValueEvent>(action)
+	    || is_action<ValueAction>(action)
+	    || is_action<MultipleValueAction>(action);
+}
+
 void CardListBase::onAction(const Action& action, bool undone) {
 	TYPE_CASE(action, AddCardAction) {
 		Freezer freeze(this);
+		sort_keys.clear(); // values of removed cards may be reused
+		changed_cards.clear();
 		if (action.action.adding != undone) {
 			// select the new cards
 			focusNone();
@@ -113,12 +123,50 @@ void CardListBase::onAction(const Action& action, bool undone) {
 		RefreshItem((long)action.card_id1);
 		RefreshItem((long)action.card_id2);
 	}
-	TYPE_CASE_(action, ScriptValueEvent) {
+	TYPE_CASE(action, ScriptValueEvent) {
 		// No refresh needed, a ScriptValueEvent is only generated in response to a ValueAction
+		invalidateSortKey(action.card, action.value);
 		return;
 	}
 	TYPE_CASE(action, ValueAction) {
-		if (action.card) refreshList(true);
+		if (action.card) {
+			invalidateSortKey(action.card, action.valueP.get());
+			refreshChangedCards();
+		}
+	}
+	TYPE_CASE(action, MultipleValueAction) {
+		FOR_EACH_CONST(a, action.actions) {
+			if (a->card) invalidateSortKey(a->card, a->valueP.get());
+		}
+		refreshChangedCards();
+	}
+}
+
+void CardListBase::refreshChangedCards() {
+	// only the changed cards have to be moved
+	vector<VoidP> changed;
+	FOR_EACH(item, sorted_list) {
+		if (find(changed_cards.begin(), changed_cards.end(), item.get()) != changed_cards.end()) {
+			changed.push_back(item);
+		}
+	}
+	changed_cards.clear();
+	refreshChangedItems(changed);
+}
+
+const String& CardListBase::getSortKey(const ValueP& value) const {
+	map<const Value*,String>::iterator it = sort_keys.find(value.get());
+	if (it == sort_keys.end()) {
+		it = sort_keys.insert(make_pair(value.get(), smart_sort_key(value->getSortKey()))).first;
+	}
+	return it->second;
+}
+
+void CardListBase::invalidateSortKey(const Card* card, const Value* value) {
+	if (sort_keys.erase(value) && card) {
+		if (find(changed_cards.begin(), changed_cards.end(), card) == changed_cards.end()) {
+			changed_cards.push_back(card);
+		}
 	}
 }
 
@@ -200,13 +248,13 @@ bool CardListBase::compareItems(void* a, void* b) const {
 	ValueP vb = reinterpret_cast<Card*>(b)->data[sort_field];
 	assert(va && vb);
 	// compare sort keys
-	int cmp = smart_compare( va->getSortKey(), vb->getSortKey() );
+	int cmp = getSortKey(va).compare(getSortKey(vb));
 	if (cmp != 0) return cmp < 0;
 	// equal values, compare alternate sort key
 	if (alternate_sort_field) {
 		ValueP va = reinterpret_cast<Card*>(a)->data[alternate_sort_field];
 		ValueP vb = reinterpret_cast<Card*>(b)->data[alternate_sort_field];
-		int cmp = smart_compare( va->getSortKey(), vb->getSortKey() );
+		int cmp = getSortKey(va).compare(getSortKey(vb));
 		if (cmp != 0) return cmp < 0;
 	}
 	return false;
@@ -215,6 +263,8 @@ bool CardListBase::compareItems(void* a, void* b) const {
 void CardListBase::rebuild() {
 	ClearAll();
 	column_fields.clear();
+	sort_keys.clear();
+	changed_cards.clear();
 	selected_item_pos = -1;
 	onRebuild();
 	if (!set) return;
@@ -84,6 +84,7 @@ class CardListBase : public ItemList, public SetView {
 	virtual void onBeforeChangeSet();
 	virtual void onChangeSet();
 	virtual void onAction(const Action&, bool undone);
+	virtual bool listensTo(const Action&) const;
 	
 	// --------------------------------------------------- : The cards
   public:
@@ -127,6 +128,18 @@ class CardListBase : public ItemList, public SetView {
 	vector<FieldP> column_fields; ///< The field to use for each column (by column index)
 	FieldP alternate_sort_field;  ///< Second field to sort by, if the column doesn't suffice
 	
+	/// Normalized sort keys of values, see smart_sort_key
+	/** Values are only identified by address, so this must be cleared when cards are removed */
+	mutable map<const Value*,String> sort_keys;
+	/// Cards whose sort keys have changed since the list was last sorted
+	vector<const Card*> changed_cards;
+	/// Get the sort key of a value, from the cache if possible
+	const String& getSortKey(const ValueP& value) const;
+	/// The sort key of a value is no longer valid
+	void invalidateSortKey(const Card* card, const Value* value);
+	/// Move the changed_cards to their new position in the list
+	void refreshChangedCards();
+	
 	mutable wxListItemAttr item_attr; // for OnGetItemAttr
 	
   public:
@@ -50,26 +50,45 @@ ImageFieldP ImageCardList::findImageField() {
 	return ImageFieldP();
 }
 
+/// Size of card thumbnails
+const int CARD_THUMBNAIL_WIDTH  = 18;
+const int CARD_THUMBNAIL_HEIGHT = 14;
+
+/// Modification time of the file a card image is loaded from
+/** Image files in a set are never overwritten, a changed image gets a new name.
+ *  So together with the name this identifies the contents of the image.
+ *  Returns an invalid time for images that are not (yet) a file in the set, those are not cached on disk.
+ */
+DateTime card_image_modified(const Set& set, const GeneratedImage& image) {
+	const ImageValueToImage* file_image = dynamic_cast<const ImageValueToImage*>(&image);
+	if (!file_image || file_image->getFilename().empty()) return DateTime();
+	return set.modificationTime(file_image->getFilename());
+}
+
 /// A request for a thumbnail of a card image
 class CardThumbnailRequest : public ThumbnailRequest {
   public:
 	CardThumbnailRequest(ImageCardList* parent, const String& key, const GeneratedImageP& imgen)
 		: ThumbnailRequest(
 			parent,
-			_("card") + parent->set->absoluteFilename() + _("-") + key,
-			wxDateTime::Now())	// TODO: Find mofication time of card image
+			// the set filename and the image code can be long, use hashes to keep the cache filename short
+			_("card-") + hash_string(parent->set->absoluteFilename()) + _("-") + hash_string(key) + hash_string(key, 1)
+				+ String::Format(_("-%dx%d"), CARD_THUMBNAIL_WIDTH, CARD_THUMBNAIL_HEIGHT),
+			card_image_modified(*parent->set, *imgen),
+			THUMBNAIL_PRIORITY_VISIBLE) // only requested for items that are shown
 		, key(key)
 		, imgen(imgen)
 	{}
 	virtual Image generate() {
 		try {
 			ImageCardList* parent = (ImageCardList*)owner;
-			GeneratedImage::Options opts;
-			opts.local_package = parent->set.get();
+			// we only need a small image, so it may be decoded at a lower resolution
+			GeneratedImage::Options opts(2 * CARD_THUMBNAIL_WIDTH, 2 * CARD_THUMBNAIL_HEIGHT, nullptr, parent->set.get());
+			opts.draft = true;
 			Image image = imgen->generate(opts);
 			// two step anti aliased resampling
-			image.Rescale(36, 28); // step 1: no anti aliassing
-			return resample(image, 18, 14); // step 2: with anti aliassing
+			image.Rescale(2 * CARD_THUMBNAIL_WIDTH, 2 * CARD_THUMBNAIL_HEIGHT); // step 1: no anti aliassing
+			return resample(image, CARD_THUMBNAIL_WIDTH, CARD_THUMBNAIL_HEIGHT); // step 2: with anti aliassing
 		} catch (...) {
 			return Image();
 		}
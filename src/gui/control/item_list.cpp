@@ -163,6 +163,46 @@ void ItemList::refreshList(bool refresh_current_only) {
 	if (sort_by_column >= 0) {
 		stable_sort(sorted_list.begin(), sorted_list.end(), ItemComparer(*this));
 	}
+	showSortedList(old_sorted_list, refresh_current_only);
+}
+
+void ItemList::refreshChangedItems(const vector<VoidP>& changed) {
+	// moving many items one by one is slower than sorting
+	if (sort_by_column < 0 || changed.size() * 4 > sorted_list.size()) {
+		refreshList(true);
+		return;
+	}
+	// are the items still the same?
+	vector<VoidP> items;
+	getItems(items);
+	vector<VoidP> old_items = sorted_list;
+	sort(items.begin(), items.end());
+	sort(old_items.begin(), old_items.end());
+	if (items != old_items) {
+		refreshList(true);
+		return;
+	}
+	// take out the changed items, the others stay in order
+	vector<VoidP> old_sorted_list = sorted_list;
+	vector<VoidP> moved;
+	size_t kept = 0;
+	for (size_t i = 0 ; i < sorted_list.size() ; ++i) {
+		if (find(changed.begin(), changed.end(), sorted_list[i]) != changed.end()) {
+			moved.push_back(sorted_list[i]);
+		} else {
+			sorted_list[kept++] = sorted_list[i];
+		}
+	}
+	sorted_list.resize(kept);
+	// and insert them at the right position
+	ItemComparer comparer(*this);
+	for (size_t i = 0 ; i < moved.size() ; ++i) {
+		sorted_list.insert(upper_bound(sorted_list.begin(), sorted_list.end(), moved[i], comparer), moved[i]);
+	}
+	showSortedList(old_sorted_list, true);
+}
+
+void ItemList::showSortedList(const vector<VoidP>& old_sorted_list, bool refresh_current_only) {
 	// Has the entire list changed?
 	if (refresh_current_only && sorted_list == old_sorted_list) {
 		if (selected_item_pos >= 0) RefreshItem(selected_item_pos);
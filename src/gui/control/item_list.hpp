@@ -72,6 +72,12 @@ class ItemList : public wxListView {
 	virtual void sortBy(long column, bool ascending);
 	/// Refresh the card list (resort, refresh and reselect current item)
 	void refreshList(bool refresh_current_only = false);
+	/// Refresh the list after some items have changed
+	/** If the list is sorted and contains the same items as before, only the changed items are moved,
+	 *  the rest of the list is assumed to still be in order.
+	 *  Otherwise this is the same as refreshList(true).
+	 */
+	void refreshChangedItems(const vector<VoidP>& changed);
 	/// Set the image of a column header (fixes wx bug)
 	void SetColumnImage(int col, int image);
 	
@@ -104,6 +110,9 @@ class ItemList : public wxListView {
   private:
 	struct ItemComparer; // for comparing items
 	
+	/// Update the control after sorted_list has changed
+	void showSortedList(const vector<VoidP>& old_sorted_list, bool refresh_current_only);
+	
 	// --------------------------------------------------- : Window events
 	DECLARE_EVENT_TABLE();
 	
@@ -61,6 +61,12 @@ void KeywordList::setFilter(const KeywordListFilterP& filter) {
 	refreshList();
 }
 
+bool KeywordList::listensTo(const Action& action) const {
+	return is_action<KeywordListAction>(action)
+	    || is_action<ValueAction>(action)
+	    || is_action<ChangeKeywordModeAction>(action);
+}
+
 void KeywordList::onAction(const Action& action, bool undone) {
 	TYPE_CASE(action, AddKeywordAction) {
 		if (action.action.adding != undone) {
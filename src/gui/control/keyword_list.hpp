@@ -47,6 +47,7 @@ class KeywordList : public ItemList, public SetView {
 	virtual void onBeforeChangeSet();
 	virtual void onChangeSet();
 	virtual void onAction(const Action&, bool);
+	virtual bool listensTo(const Action&) const;
 	void updateUsageStatistics();
 	
 	// --------------------------------------------------- : Selection
@@ -13,8 +13,10 @@
 #include <data/set.hpp>
 #include <data/card.hpp>
 #include <data/stylesheet.hpp>
+#include <data/export_template.hpp> // for ExportImageWriter
 #include <render/card/viewer.hpp>
 #include <wx/print.h>
+#include <wx/filename.h>
 
 DECLARE_TYPEOF_COLLECTION(CardP);
 DECLARE_POINTER_TYPE(PageLayout);
@@ -49,6 +51,53 @@ void PageLayout::init(const StyleSheet& stylesheet, PageLayoutType type, const R
 	}
 }
 
+RealPoint PageLayout::cardPosition(int card_nr) const {
+	int col = card_nr % cols;
+	int row = card_nr / cols;
+	return RealPoint( margin_left + (card_size.width  + card_spacing.width)  * col
+	                , margin_top  + (card_size.height + card_spacing.height) * row);
+}
+
+Radians PageLayout::cardRotation(const StyleSheet& stylesheet) const {
+	if ((stylesheet.card_width > stylesheet.card_height) != card_landscape) {
+		return rad90;
+	} else {
+		return 0;
+	}
+}
+
+// ----------------------------------------------------------------------------- : Rendering cards
+
+/// Render a card for printing, rotated to fit the layout, zoom is relative to the stylesheet's resolution
+Bitmap render_print_card(DataViewer& viewer, const PrintJob& job, const CardP& card, double zoom) {
+	const StyleSheet& stylesheet = job.set->stylesheetFor(card);
+	Radians rotation = job.layout.cardRotation(stylesheet);
+	/*
+	// size of this particular card (in mm)
+	RealSize card_size( stylesheet.card_width  * 25.4 / stylesheet.card_dpi
+	                  , stylesheet.card_height * 25.4 / stylesheet.card_dpi);
+	if (is_rad90(rotation)) swap(card_size.width, card_size.height);
+	// adjust card size, to center card in the available space (from job->layout.card_size)?
+	// TODO: deal with different sized cards in general
+	*/
+	
+	// create buffers
+	int w = int(stylesheet.card_width), h = int(stylesheet.card_height); // in pixels
+	if (is_rad90(rotation)) swap(w,h);
+	// Draw using text buffer
+	Bitmap buffer(int(w*zoom),int(h*zoom),32);
+	if (!buffer.Ok()) throw InternalError(_("Unable to create bitmap"));
+	wxMemoryDC bufferDC;
+	bufferDC.SelectObject(buffer);
+	clearDC(bufferDC,*wxWHITE_BRUSH);
+	RotatedDC rdc(bufferDC, rotation, stylesheet.getCardRect(), zoom, QUALITY_AA, ROTATION_ATTACH_TOP_LEFT);
+	// render card to dc
+	viewer.setCard(card);
+	viewer.draw(rdc, *wxWHITE);
+	bufferDC.SelectObject(wxNullBitmap);
+	return buffer;
+}
+
 // ----------------------------------------------------------------------------- : Printout
 
 /// A printout object specifying how to print a specified set of cards
@@ -120,44 +169,15 @@ bool CardsPrintout::OnPrintPage(int page) {
 }
 
 void CardsPrintout::drawCard(DC& dc, const CardP& card, int card_nr) {
-	// determine position
-	int col = card_nr % job->layout.cols;
-	int row = card_nr / job->layout.cols;
-	RealPoint pos( job->layout.margin_left + (job->layout.card_size.width  + job->layout.card_spacing.width)  * col
-	             , job->layout.margin_top  + (job->layout.card_size.height + job->layout.card_spacing.height) * row);
-	// determine rotation
+	RealPoint pos = job->layout.cardPosition(card_nr);
 	const StyleSheet& stylesheet = job->set->stylesheetFor(card);
-	Radians rotation = 0;
-	if ((stylesheet.card_width > stylesheet.card_height) != job->layout.card_landscape) {
-		rotation = rad90;
-	}
-	/*
-	// size of this particular card (in mm)
-	RealSize card_size( stylesheet.card_width  * 25.4 / stylesheet.card_dpi
-	                  , stylesheet.card_height * 25.4 / stylesheet.card_dpi);
-	if (is_rad90(rotation)) swap(card_size.width, card_size.height);
-	// adjust card size, to center card in the available space (from job->layout.card_size)?
-	// TODO: deal with different sized cards in general
-	*/
-	
-	// create buffers
-	int w = int(stylesheet.card_width), h = int(stylesheet.card_height); // in pixels
-	if (is_rad90(rotation)) swap(w,h);
-	// Draw using text buffer
-	double zoom = IsPreview() ? 1 : 4;
-	wxBitmap buffer(w*zoom,h*zoom,32);
-	wxMemoryDC bufferDC;
-	bufferDC.SelectObject(buffer);
-	clearDC(bufferDC,*wxWHITE_BRUSH);
-	RotatedDC rdc(bufferDC, rotation, stylesheet.getCardRect(), zoom, QUALITY_AA, ROTATION_ATTACH_TOP_LEFT);
-	// render card to dc
-	viewer.setCard(card);
-	viewer.draw(rdc, *wxWHITE);
+	// render at the resolution of the printer, but no more than 4 times that of the card
+	double zoom = IsPreview() ? 1 : max(1.0, min(4.0, scale_x * 25.4 / stylesheet.card_dpi));
+	Bitmap buffer = render_print_card(viewer, *job, card, zoom);
 	// render buffer to device
 	double px_per_mm = zoom * stylesheet.card_dpi / 25.4;
 	dc.SetUserScale(scale_x / px_per_mm, scale_y / px_per_mm);
 	dc.SetDeviceOrigin(int(scale_x * pos.x), int(scale_y * pos.y));
-	bufferDC.SelectObject(wxNullBitmap);
 	dc.DrawBitmap(buffer, 0, 0);
 }
 
@@ -215,6 +235,45 @@ void print_set(Window* parent, const PrintJobP& job) {
 	p.Print(parent, &pout, true);
 }
 
+// ----------------------------------------------------------------------------- : Printing to images
+
+void print_to_images(const PrintJobP& job, const String& filename, double dpi, const RealSize& page_size) {
+	if (!job || !job->set) throw Error(_("no set"));
+	if (job->layout.empty()) {
+		job->layout.init(*job->set->stylesheet, job->layout_type, page_size);
+	}
+	if (job->layout.empty()) throw Error(_("The cards do not fit on the page"));
+	int type = image_type_for_file(filename);
+	if (type == wxBITMAP_TYPE_INVALID) throw Error(_("Unknown image file type: ") + filename);
+	double px_per_mm = dpi / 25.4;
+	int page_width  = int(job->layout.page_size.width  * px_per_mm);
+	int page_height = int(job->layout.page_size.height * px_per_mm);
+	DataViewer viewer;
+	viewer.setSet(job->set);
+	ExportImageWriter writer;
+	int pages = job->num_pages();
+	for (int page = 0 ; page < pages ; ++page) {
+		// render the cards one at a time, so only a single card buffer is needed besides the page
+		Image sheet(page_width, page_height, false);
+		memset(sheet.GetData(), 255, page_width * page_height * 3); // white
+		int start = page * job->layout.cards_per_page();
+		int end   = min((int)job->cards.size(), start + job->layout.cards_per_page());
+		for (int i = start ; i < end ; ++i) {
+			const CardP& card = job->cards.at(i);
+			double zoom = dpi / job->set->stylesheetFor(card).card_dpi;
+			Image card_image = render_print_card(viewer, *job, card, zoom).ConvertToImage();
+			RealPoint pos = job->layout.cardPosition(i - start);
+			sheet.Paste(card_image, int(pos.x * px_per_mm), int(pos.y * px_per_mm));
+		}
+		// encode and write in the background, but don't keep too many pages in memory
+		wxFileName fn(filename);
+		if (pages > 1) fn.SetName(fn.GetName() + String::Format(_("-%d"), page + 1));
+		writer.limit(max(1, wxThread::GetCPUCount()));
+		writer.write(sheet, fn.GetFullPath(), type);
+	}
+	writer.finish();
+}
+
 void print_preview(Window* parent, const SetP& set, const ExportCardSelectionChoices& choices) {
 	print_preview(parent, make_print_job(parent, set, choices));
 }
@@ -12,6 +12,7 @@
 #include <util/prec.hpp>
 #include <util/reflect.hpp>
 #include <util/real_point.hpp>
+#include <util/angle.hpp>
 #include <data/settings.hpp>
 #include <gui/card_select_window.hpp>
 
@@ -39,6 +40,11 @@ class PageLayout {
 	inline bool empty() const { return cards_per_page() == 0; }
 	/// The number of cards per page
 	inline int cards_per_page() const { return rows * cols; }
+	
+	/// Position of the top left corner of the card_nr-th card on a page (in millimetres)
+	RealPoint cardPosition(int card_nr) const;
+	/// Rotation needed for cards with the given stylesheet to match card_landscape
+	Radians cardRotation(const StyleSheet& stylesheet) const;
 };
 
 class PrintJob : public IntrusivePtrBase<PrintJob> {
@@ -72,5 +78,12 @@ void print_preview(Window* parent, const SetP& set, const ExportCardSelectionCho
 void print_set(Window* parent, const PrintJobP& job);
 void print_set(Window* parent, const SetP& set, const ExportCardSelectionChoices& choices);
 
+/// Render the pages of a print job to image files, without a printer
+/** The layout is initialized for the given page size (in millimetres) if needed.
+ *  With more than one page, the page number is added to the filename.
+ *  Pages are rendered one at a time, and written to disk in the background.
+ */
+void print_to_images(const PrintJobP& job, const String& filename, double dpi, const RealSize& page_size);
+
 // ----------------------------------------------------------------------------- : EOF
 #endif
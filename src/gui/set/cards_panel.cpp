@@ -21,6 +21,7 @@
 #include <data/card.hpp>
 #include <data/add_cards_script.hpp>
 #include <data/action/set.hpp>
+#include <data/action/value.hpp>
 #include <data/settings.hpp>
 #include <util/find_replace.hpp>
 #include <util/tagged_string.hpp>
@@ -466,7 +467,29 @@ bool CardsPanel::doReplace(wxFindReplaceData& what) {
 	return search(find, false);
 }
 bool CardsPanel::doReplaceAll(wxFindReplaceData& what) {
-	return false; // TODO
+	ReplaceFindInfo find(*this, what);
+	if (find.findString().empty()) return false;
+	String replacement = escape(what.GetReplaceString());
+	// replace in all cards as a single action, so scripts are only updated once
+	MultipleValueAction* action = new MultipleValueAction(_("Replace all"));
+	FOR_EACH(card, set->cards) {
+		FOR_EACH(value, card->data) {
+			if (!value->fieldP->editable || !dynamic_cast<TextField*>(value->fieldP.get())) continue;
+			String val = value->value->toString();
+			String new_val = tagged_replace_all(val, find.findString(), replacement, find.caseSensitive(), find.wholeWord());
+			if (new_val != val) {
+				ValueAction* a = value_action(value, to_script(new_val));
+				a->isOnCard(card.get());
+				action->add(a);
+			}
+		}
+	}
+	if (action->actions.empty()) {
+		delete action;
+		return false;
+	}
+	set->actions.addAction(action);
+	return true;
 }
 
 bool CardsPanel::search(FindInfo& find, bool from_start) {
@@ -316,6 +316,11 @@ void KeywordsPanel::onChangeSet() {
 	panel->Layout();
 }
 
+bool KeywordsPanel::listensTo(const Action& action) const {
+	return is_action<ValueAction>(action)
+	    || is_action<ChangeKeywordModeAction>(action);
+}
+
 void KeywordsPanel::onAction(const Action& action, bool undone) {
 	if (!isInitialized()) return;
 	TYPE_CASE(action, ValueAction) {
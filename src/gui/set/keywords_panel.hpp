@@ -30,6 +30,7 @@ class KeywordsPanel : public SetWindowPanel {
 	
 	virtual void onChangeSet();
 	virtual void onAction(const Action&, bool);
+	virtual bool listensTo(const Action&) const;
 	
 	// --------------------------------------------------- : UI
 	
@@ -475,6 +475,10 @@ void RandomPackPanel::onChangeSet() {
 	updateTotals();
 }
 
+bool RandomPackPanel::listensTo(const Action& action) const {
+	return is_action<PackTypesAction>(action);
+}
+
 void RandomPackPanel::onAction(const Action& action, bool undone) {
 	TYPE_CASE_(action, PackTypesAction) {
 		// rebuild the list
@@ -47,6 +47,7 @@ class RandomPackPanel : public SetWindowPanel {
 	virtual void onBeforeChangeSet();
 	virtual void onChangeSet();
 	virtual void onAction(const Action&, bool undone);
+	virtual bool listensTo(const Action&) const;
 	
 	virtual void initUI   (wxToolBar* tb, wxMenuBar* mb);
 	virtual void destroyUI(wxToolBar* tb, wxMenuBar* mb);
@@ -348,6 +348,10 @@ void StatsPanel::onChangeSet() {
 	onChange();
 }
 
+bool StatsPanel::listensTo(const Action& action) const {
+	return !is_action<ScriptValueEvent>(action); // ignore style only stuff
+}
+
 void StatsPanel::onAction(const Action& action, bool undone) {
 	if (!isInitialized()) return;
 	TYPE_CASE_(action, ScriptValueEvent) {
@@ -35,6 +35,7 @@ class StatsPanel : public SetWindowPanel {
 	
 	virtual void onChangeSet();
 	virtual void onAction(const Action&, bool undone);
+	virtual bool listensTo(const Action&) const;
 	
 	virtual void initUI   (wxToolBar*, wxMenuBar*);
 	virtual void destroyUI(wxToolBar*, wxMenuBar*);
@@ -94,6 +94,12 @@ void StylePanel::onChangeSet() {
 	use_for_all->Enable(false);
 }
 
+bool StylePanel::listensTo(const Action& action) const {
+	return is_action<DisplayChangeAction>(action)
+	    || is_action<ValueAction>(action)
+	    || is_action<MultipleValueAction>(action);
+}
+
 void StylePanel::onAction(const Action& action, bool undone) {
 	if (!isInitialized()) return;
 	TYPE_CASE_(action, ChangeSetStyleAction) {
@@ -124,6 +130,16 @@ void StylePanel::onAction(const Action& action, bool undone) {
 			}
 		}
 	}
+	TYPE_CASE(action, MultipleValueAction) {
+		// are any of them styling actions?
+		const StyleSheet& s = set->stylesheetFor(card);
+		FOR_EACH_CONST(a, action.actions) {
+			if (!a->card && find(s.styling_fields.begin(), s.styling_fields.end(), a->valueP->fieldP) != s.styling_fields.end()) {
+				preview->redraw();
+				return;
+			}
+		}
+	}
 	use_for_all->Enable(card && card->stylesheet);
 	use_custom_options->Enable(card);
 	use_custom_options->SetValue(card ? card->has_styling : false);
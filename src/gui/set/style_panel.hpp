@@ -25,6 +25,7 @@ class StylePanel : public SetWindowPanel {
 	
 	virtual void onChangeSet();
 	virtual void onAction(const Action&, bool undone);
+	virtual bool listensTo(const Action&) const;
 	
 	// --------------------------------------------------- : UI
 	
@@ -315,6 +315,11 @@ void SetWindow::onChangeSet() {
 	fixMinWindowSize();
 }
 
+bool SetWindow::listensTo(const Action& action) const {
+	return is_action<ValueAction>(action)
+	    || is_action<MultipleValueAction>(action);
+}
+
 void SetWindow::onAction(const Action& action, bool undone) {
 	TYPE_CASE(action, ValueAction) {
 		if (!action.card) {
@@ -323,6 +328,14 @@ void SetWindow::onAction(const Action& action, bool undone) {
 			}
 		}
 	}
+	TYPE_CASE(action, MultipleValueAction) {
+		FOR_EACH_CONST(a, action.actions) {
+			if (!a->card && set->data.contains(a->valueP) && a->valueP->fieldP->identifying) {
+				updateTitle();
+				break;
+			}
+		}
+	}
 /*	TYPE_CASE_(action, DisplayChangeAction) {
 		// The style changed, maybe also the size of card viewers
 		if (current_panel) current_panel->Layout();
@@ -79,6 +79,7 @@ class SetWindow : public wxFrame, public SetView {
 	virtual void onChangeSet();
 	/// Actions that change the set
 	virtual void onAction(const Action&, bool undone);
+	virtual bool listensTo(const Action&) const;
 	
   public:
 	// minSize = mainSizer->getMinWindowSize(this)
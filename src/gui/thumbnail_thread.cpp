@@ -10,10 +10,25 @@
 #include <gui/thumbnail_thread.hpp>
 #include <util/platform.hpp>
 #include <util/error.hpp>
+#include <util/file_utils.hpp>
+#include <script/profiler.hpp>
 #include <wx/thread.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
 
 typedef pair<ThumbnailRequestP,Image> pair_ThumbnailRequestP_Image;
 DECLARE_TYPEOF_COLLECTION(pair_ThumbnailRequestP_Image);
+DECLARE_TYPEOF_COLLECTION(ThumbnailRequestP);
+DECLARE_TYPEOF_COLLECTION(ThumbnailThreadWorker*);
+DECLARE_TYPEOF(map<String COMMA vector<ThumbnailRequestP> >);
+
+/// Maximum number of worker threads for generating thumbnails
+const int MAX_THUMBNAIL_WORKERS = 4;
+
+/// Thumbnails that have not been used for this many days are removed from the image cache
+const int IMAGE_CACHE_MAX_AGE = 60;
+/// Maximum total size of the image cache, the least recently used thumbnails are removed first
+const unsigned long IMAGE_CACHE_MAX_SIZE = 64 * 1024 * 1024;
 
 // ----------------------------------------------------------------------------- : Image Cache
 
@@ -39,6 +54,104 @@ String safe_filename(const String& str) {
 	return ret;
 }
 
+/// Prefix of the cache filename for a request, the same for all versions of the thumbnail
+/** Only the start of the name is readable, the hash keeps long names apart */
+String cache_prefix(const ThumbnailRequest& request) {
+	return safe_filename(request.cache_name.substr(0, 64)) + _("-") + hash_string(request.cache_name) + _("-");
+}
+
+/// Filename of the thumbnail for a request in the image cache
+/** The modification time of the source is part of the name, so a thumbnail of a changed package gets a different file
+ */
+String cache_filename(const ThumbnailRequest& request) {
+	String stamp = String::Format(_("%ld"), (long)request.modified.GetTicks());
+	return image_cache_dir() + cache_prefix(request) + hash_string(stamp + request.cache_name) + _(".png");
+}
+
+/// Load the thumbnail for a request from the image cache, if it is there
+bool load_from_cache(const ThumbnailRequest& request, Image& img) {
+	if (!request.modified.IsValid()) return false;
+	String filename = cache_filename(request);
+	if (!wxFileExists(filename)) return false;
+	if (!img.LoadFile(filename, wxBITMAP_TYPE_PNG)) return false;
+	// the modification time tells prune_image_cache when the thumbnail was last used
+	if (file_modified_time(filename) < time(nullptr) - 24*60*60) {
+		wxFileName(filename).Touch();
+	}
+	return true;
+}
+
+/// Store a thumbnail in the image cache
+/** Older versions of the thumbnail are removed later, by prune_image_cache */
+void store_in_cache(const ThumbnailRequest& request, const Image& img) {
+	if (!request.modified.IsValid() || !img.Ok()) return;
+	img.SaveFile(cache_filename(request), wxBITMAP_TYPE_PNG);
+}
+
+/// A file in the image cache
+struct ImageCacheFile {
+	time_t        used; ///< Modification time, updated when the thumbnail is loaded
+	unsigned long size;
+	String        name;
+	inline bool operator < (const ImageCacheFile& that) const { return used < that.used; }
+};
+
+/// Remove thumbnails of older versions, and thumbnails that have not been used for a while, from the image cache
+/** This scans the entire cache directory, so it is only done once per run.
+ *  Files written after the scan started are left alone, thumbnails may be stored at the same time.
+ */
+void prune_image_cache() {
+	time_t start   = time(nullptr);
+	time_t too_old = start - IMAGE_CACHE_MAX_AGE * 24*60*60;
+	String dirname = image_cache_dir();
+	wxDir dir(dirname);
+	if (!dir.IsOpened()) return;
+	// newest version of each thumbnail, by cache_prefix
+	map<String,ImageCacheFile> newest;
+	vector<String> old_files;
+	String name;
+	bool more = dir.GetFirst(&name, _("*.png"), wxDIR_FILES);
+	while (more) {
+		// name is cache_prefix + 8 digit hash + ".png"
+		ImageCacheFile file;
+		file.used = file_modified_time(dirname + name);
+		file.size = wxFileName::GetSize(dirname + name).ToULong();
+		file.name = name;
+		if (name.size() <= 12 || file.used >= start) {
+			// not a thumbnail, or just stored
+		} else if (file.used < too_old) {
+			old_files.push_back(name);
+		} else {
+			String prefix = name.substr(0, name.size() - 12);
+			map<String,ImageCacheFile>::iterator it = newest.find(prefix);
+			if (it == newest.end()) {
+				newest.insert(make_pair(prefix, file));
+			} else if (it->second.used < file.used) {
+				old_files.push_back(it->second.name);
+				it->second = file;
+			} else {
+				old_files.push_back(name);
+			}
+		}
+		more = dir.GetNext(&name);
+	}
+	// limit the total size, remove the least recently used thumbnails first
+	vector<ImageCacheFile> files;
+	unsigned long total_size = 0;
+	for (map<String,ImageCacheFile>::const_iterator it = newest.begin() ; it != newest.end() ; ++it) {
+		files.push_back(it->second);
+		total_size += it->second.size;
+	}
+	sort(files.begin(), files.end());
+	for (size_t i = 0 ; i < files.size() && total_size > IMAGE_CACHE_MAX_SIZE ; ++i) {
+		old_files.push_back(files[i].name);
+		total_size -= files[i].size;
+	}
+	FOR_EACH(f, old_files) {
+		wxRemoveFile(dirname + f);
+	}
+}
+
 // ----------------------------------------------------------------------------- : ThumbnailThreadWorker
 
 class ThumbnailThreadWorker : public wxThread {
@@ -49,25 +162,30 @@ class ThumbnailThreadWorker : public wxThread {
 	
 	ThumbnailRequestP current; ///< Request we are working on
 	ThumbnailThread*  parent;
-	bool              stop; ///< Suspend computation
 };
 
 ThumbnailThreadWorker::ThumbnailThreadWorker(ThumbnailThread* parent)
 	: parent(parent)
-	, stop(false)
 {}
 
 wxThread::ExitCode ThumbnailThreadWorker::Entry() {
+	PROFILER_THREAD;
+	// the first worker of this run cleans up the image cache
+	bool prune;
+	{
+		wxMutexLocker lock(parent->mutex);
+		prune = !parent->cache_pruned;
+		parent->cache_pruned = true;
+	}
+	if (prune) prune_image_cache();
 	while (true) {
-		do {
-			Sleep(1);
-		} while (stop);
 		// get a request
 		{
 			wxMutexLocker lock(parent->mutex);
 			if (parent->open_requests.empty()) {
-				parent->worker = nullptr;
-				return 0; // No more requests
+				// No more requests
+				parent->workers.erase(find(parent->workers.begin(), parent->workers.end(), this));
+				return 0;
 			}
 			current = parent->open_requests.front();
 			parent->open_requests.pop_front();
@@ -81,19 +199,13 @@ wxThread::ExitCode ThumbnailThreadWorker::Entry() {
 		} catch (...) {
 		}
 		// store in cache
-		if (img.Ok()) {
-			String filename = image_cache_dir() + safe_filename(current->cache_name) + _(".png");
-			img.SaveFile(filename, wxBITMAP_TYPE_PNG);
-			// set modification time
-			wxFileName fn(filename);
-			fn.SetTimes(0, &current->modified, 0);
-		}
+		store_in_cache(*current, img);
 		// store result in closed request list
 		{
 			wxMutexLocker lock(parent->mutex);
-			parent->closed_requests.push_back(make_pair(current,img));
+			parent->complete(current, img);
 			current = ThumbnailRequestP();
-			parent->completed.Signal();
+			parent->completed.Broadcast();
 		}
 	}
 }
@@ -110,7 +222,7 @@ ThumbnailThread thumbnail_thread;
 
 ThumbnailThread::ThumbnailThread()
 	: completed(mutex)
-	, worker(nullptr)
+	, cache_pruned(false)
 {}
 
 void ThumbnailThread::request(const ThumbnailRequestP& request) {
@@ -120,33 +232,36 @@ void ThumbnailThread::request(const ThumbnailRequestP& request) {
 		return;
 	}
 	// Is the image in the cache?
-	String filename = image_cache_dir() + safe_filename(request->cache_name) + _(".png");
-	wxFileName fn(filename);
-	if (fn.FileExists()) {
-		wxDateTime modified;
-		if (fn.GetTimes(0, &modified, 0) && modified >= request->modified) {
-			// yes it is
-			Image img(filename);
-			request->store(img);
-			return;
-		}
+	Image img;
+	if (load_from_cache(*request, img)) {
+		request->store(img);
+		return;
 	}
 	if (request->threadSafe()) {
 		request_names.insert(request);
 		// request generation
-		{
-			wxMutexLocker lock(mutex);
-			open_requests.push_back(request);
-		}
-		// is there a worker?
-		if (!worker) {
-			worker = new ThumbnailThreadWorker(this);
-			worker->Create();
-			worker->Run();
+		wxMutexLocker lock(mutex);
+		map<String,vector<ThumbnailRequestP> >::iterator it = coalesced.find(request->cache_name);
+		if (it != coalesced.end()) {
+			// the same thumbnail is already being generated for another owner, share the result
+			it->second.push_back(request);
+			// make sure it doesn't wait on a lower priority request
+			FOR_EACH(r, open_requests) {
+				if (r->cache_name == request->cache_name && r->priority < request->priority) {
+					ThumbnailRequestP open = r;
+					open_requests.erase(find(open_requests.begin(), open_requests.end(), open));
+					open->priority = request->priority;
+					enqueue(open);
+					break;
+				}
+			}
+		} else {
+			coalesced.insert(make_pair(request->cache_name, vector<ThumbnailRequestP>()));
+			enqueue(request);
+			startWorkers();
 		}
 	}
 	else {
-		Image img;
 		try {
 			img = request->generate();
 		} catch (const Error& e) {
@@ -154,18 +269,52 @@ void ThumbnailThread::request(const ThumbnailRequestP& request) {
 		} catch (...) {
 		}
 		// store in cache
-		if (img.Ok()) {
-			String filename = image_cache_dir() + safe_filename(request->cache_name) + _(".png");
-			img.SaveFile(filename, wxBITMAP_TYPE_PNG);
-			// set modification time
-			wxFileName fn(filename);
-			fn.SetTimes(0, &request->modified, 0);
-		}
+		store_in_cache(*request, img);
 		{
 			wxMutexLocker lock(mutex);
 			closed_requests.push_back(make_pair(request,img));
-			completed.Signal();
+			completed.Broadcast();
+		}
+	}
+}
+
+void ThumbnailThread::enqueue(const ThumbnailRequestP& request) {
+	// insert after all requests with the same or a higher priority
+	deque<ThumbnailRequestP>::iterator it = open_requests.end();
+	while (it != open_requests.begin() && (*(it - 1))->priority < request->priority) {
+		--it;
+	}
+	open_requests.insert(it, request);
+}
+
+void ThumbnailThread::startWorkers() {
+	int max_workers = max(1, min(MAX_THUMBNAIL_WORKERS, wxThread::GetCPUCount()));
+	while (workers.size() < open_requests.size() && (int)workers.size() < max_workers) {
+		ThumbnailThreadWorker* worker = new ThumbnailThreadWorker(this);
+		if (worker->Create() != wxTHREAD_NO_ERROR) {
+			delete worker;
+			break;
 		}
+		workers.push_back(worker);
+		worker->Run();
+	}
+}
+
+bool ThumbnailThread::inProgress(void* owner) const {
+	FOR_EACH_CONST(w, workers) {
+		if (w->current && w->current->owner == owner) return true;
+	}
+	return false;
+}
+
+void ThumbnailThread::complete(const ThumbnailRequestP& request, const Image& img) {
+	closed_requests.push_back(make_pair(request,img));
+	map<String,vector<ThumbnailRequestP> >::iterator it = coalesced.find(request->cache_name);
+	if (it != coalesced.end()) {
+		FOR_EACH(r, it->second) {
+			closed_requests.push_back(make_pair(r,img));
+		}
+		coalesced.erase(it);
 	}
 }
 
@@ -197,24 +346,41 @@ bool ThumbnailThread::done(void* owner) {
 
 void ThumbnailThread::abort(void* owner) {
 	assert(wxThread::IsMain());
-	mutex.Lock();
-	if (worker && worker->current && worker->current->owner == owner) {
-		// a request for this owner is in progress, wait until it is done
-		worker->stop = true;
-		completed.Wait();
-		mutex.Lock();
-		worker->stop = false;
+	wxMutexLocker lock(mutex);
+	// remove requests of this owner that are waiting for another request
+	FOR_EACH(c, coalesced) {
+		vector<ThumbnailRequestP>& waiting = c.second;
+		for (size_t i = 0 ; i < waiting.size() ; ) {
+			if (waiting[i]->owner == owner) {
+				request_names.erase(waiting[i]);
+				waiting.erase(waiting.begin() + i);
+			} else {
+				++i;
+			}
+		}
 	}
 	// remove open requests for this owner
 	for (size_t i = 0 ; i < open_requests.size() ; ) {
 		if (open_requests[i]->owner == owner) {
-			// remove
 			request_names.erase(open_requests[i]);
-			open_requests.erase(open_requests.begin() + i, open_requests.begin() + i + 1);
+			map<String,vector<ThumbnailRequestP> >::iterator it = coalesced.find(open_requests[i]->cache_name);
+			if (it != coalesced.end() && !it->second.empty()) {
+				// another owner is waiting for the same thumbnail, it takes over the request
+				open_requests[i] = it->second.front();
+				it->second.erase(it->second.begin());
+				++i;
+			} else {
+				if (it != coalesced.end()) coalesced.erase(it);
+				open_requests.erase(open_requests.begin() + i);
+			}
 		} else {
 			++i;
 		}
 	}
+	// a request for this owner might be in progress, wait until it is done
+	while (inProgress(owner)) {
+		completed.Wait();
+	}
 	// remove closed requests for this owner
 	for (size_t i = 0 ; i < closed_requests.size() ; ) {
 		if (closed_requests[i].first->owner == owner) {
@@ -225,23 +391,26 @@ void ThumbnailThread::abort(void* owner) {
 			++i;
 		}
 	}
-	mutex.Unlock();
 }
 
 void ThumbnailThread::abortAll() {
 	assert(wxThread::IsMain());
-	mutex.Lock();
+	wxMutexLocker lock(mutex);
 	open_requests.clear();
+	coalesced.clear();
 	closed_requests.clear();
 	request_names.clear();
-	// end worker
-	if (worker && worker->current) {
-		completed.Wait();
-	} else {
-		mutex.Unlock();
+	// wait for workers to finish their current request
+	bool busy = true;
+	while (busy) {
+		busy = false;
+		FOR_EACH(w, workers) {
+			if (w->current) busy = true;
+		}
+		if (busy) completed.Wait();
 	}
-	// There may still be a worker, but if there is, it has no current object, so it is
-	// in, before or after the stop loop. It can do nothing but end.
-	// An unfortunate side effect is that we might leak some memory (of the worker object),
-	// when the thread gets Kill()ed by wx.
+	// There may still be workers, but if there are, they have no current object, so they
+	// can do nothing but end.
+	// An unfortunate side effect is that we might leak some memory (of the worker objects),
+	// when the threads get Kill()ed by wx.
 }
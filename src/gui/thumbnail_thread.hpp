@@ -19,20 +19,30 @@ class ThumbnailThreadWorker;
 
 // ----------------------------------------------------------------------------- : ThumbnailRequest
 
+/// Priorities of thumbnail requests, requests with a higher priority are generated first
+enum ThumbnailPriority
+{	THUMBNAIL_PRIORITY_LOW     = -1	///< Thumbnails that are not visible yet
+,	THUMBNAIL_PRIORITY_NORMAL  = 0
+,	THUMBNAIL_PRIORITY_VISIBLE = 1	///< Thumbnails that are visible on the screen
+};
+
 /// A request for some kind of thumbnail
 class ThumbnailRequest : public IntrusivePtrVirtualBase {
   public:
-	ThumbnailRequest(void* owner, const String& cache_name, const wxDateTime& modified)
-		: owner(owner), cache_name(cache_name), modified(modified) {}
+	ThumbnailRequest(void* owner, const String& cache_name, const wxDateTime& modified, int priority = THUMBNAIL_PRIORITY_NORMAL)
+		: owner(owner), cache_name(cache_name), modified(modified), priority(priority) {}
 	
 	virtual ~ThumbnailRequest() {}
 	
 	/// Generate the thumbnail, called in another thread
+	/** Multiple worker threads can be generating thumbnails at the same time,
+	 *  so this must not modify objects that other requests or the main thread use.
+	 */
 	virtual Image generate() = 0;
 	/// Store the thumbnail, called from the main thread
 	virtual void store(const Image&) = 0;
 
-	/// Can the thumbnail safely be generated from another thread?
+	/// Can the thumbnail safely be generated from another thread, at the same time as other thumbnails?
 	virtual bool threadSafe() const { return true; }
 	
 	/// Object that requested the thumbnail
@@ -40,16 +50,21 @@ class ThumbnailRequest : public IntrusivePtrVirtualBase {
 	/// Name under which this object will be stored in the image cache
 	String cache_name;
 	/// Modification time for the object of which the thumnail is generated
+	/** If this is not a valid time, the thumbnail is not cached on disk */
 	wxDateTime modified;
+	/// Priority of this request, see ThumbnailPriority
+	int priority;
 };
 
 // ----------------------------------------------------------------------------- : ThumbnailThread
 
-/// A (generic) class that generates thumbnails in another thread
+/// A (generic) class that generates thumbnails in other threads
 /** All requests have an 'owner', the object that requested the thumbnail.
  *  This object should regularly call "done(this)".
- *  Multiple requests can be open at the same time.
- *  Thumbnails are cached, and need not be generated in a thread
+ *  Multiple requests can be open at the same time, they are handled by a pool of worker threads,
+ *  highest priority first.
+ *  Requests with the same cache_name are only generated once.
+ *  Thumbnails are cached on disk, and need not be generated in a thread
  */
 class ThumbnailThread {
   public:
@@ -67,14 +82,25 @@ class ThumbnailThread {
 	void abortAll();
 	
   private:
-	wxMutex     mutex;  ///< Mutex used by the worker when accessing the request lists or the thread pointer
+	wxMutex     mutex;  ///< Mutex used by the workers when accessing the request lists or the worker list
 	wxCondition completed; ///< Event signaled when a request is completed
 	
-	deque<ThumbnailRequestP>                open_requests;		///< Requests on which work hasn't finished
+	deque<ThumbnailRequestP>                open_requests;		///< Requests on which work hasn't started, highest priority first
+	map<String,vector<ThumbnailRequestP> >  coalesced;			///< Requests waiting for an open or running request with the same cache_name
 	vector<pair<ThumbnailRequestP,Image> >  closed_requests;	///< Requests for which work is completed
 	set<ThumbnailRequestP>                  request_names;		///< Requests that haven't been stored yet, to prevent duplicates
 	friend class ThumbnailThreadWorker;
-	ThumbnailThreadWorker* worker;								///< The worker thread. invariant: no requests ==> worker==nullptr
+	vector<ThumbnailThreadWorker*>          workers;			///< The worker threads. invariant: no requests ==> workers.empty()
+	bool                                    cache_pruned;		///< Have old thumbnails been removed from the image cache in this run?
+	
+	/// Add a request to the open list, in order of priority
+	void enqueue(const ThumbnailRequestP& request);
+	/// Start more workers if there are open requests waiting for one. The mutex must be locked
+	void startWorkers();
+	/// Is any worker busy with a request for the given owner? The mutex must be locked
+	bool inProgress(void* owner) const;
+	/// Move a request and the requests coalesced with it to the closed list. The mutex must be locked
+	void complete(const ThumbnailRequestP& request, const Image& img);
 };
 
 /// The global thumbnail generator thread
@@ -20,7 +20,7 @@ DECLARE_TYPEOF_COLLECTION(ChoiceField::ChoiceP);
 
 class ChoiceThumbnailRequest : public ThumbnailRequest {
   public:
-	ChoiceThumbnailRequest(ValueViewer* cve, int id, bool from_disk, bool thread_safe);
+	ChoiceThumbnailRequest(ValueViewer* cve, int id, bool from_disk, bool thread_safe, int priority);
 	virtual Image generate();
 	virtual void store(const Image&);
 
@@ -33,12 +33,13 @@ class ChoiceThumbnailRequest : public ThumbnailRequest {
 	inline ValueViewer& viewer() { return *static_cast<ValueViewer*>(owner); }
 };
 
-ChoiceThumbnailRequest::ChoiceThumbnailRequest(ValueViewer* viewer, int id, bool from_disk, bool thread_safe)
+ChoiceThumbnailRequest::ChoiceThumbnailRequest(ValueViewer* viewer, int id, bool from_disk, bool thread_safe, int priority)
 	: ThumbnailRequest(
 		static_cast<void*>(viewer),
 		viewer->getStylePackage().name() + _("/") + viewer->getField()->name + _("/") << id,
 		from_disk ? viewer->getStylePackage().lastModified()
-		          : wxDateTime::Now()
+		          : wxDateTime(), // not cached on disk
+		priority
 	)
 	, isThreadSafe(thread_safe)
 	, id(id)
@@ -47,10 +48,10 @@ ChoiceThumbnailRequest::ChoiceThumbnailRequest(ValueViewer* viewer, int id, bool
 Image ChoiceThumbnailRequest::generate() {
 	ChoiceStyle& s = style();
 	String name = canonical_name_form(s.field().choices->choiceName(id));
-	ScriptableImage& img = s.choice_images[name];
-	return img.isReady()
-		? img.generate(GeneratedImage::Options(16,16, &viewer().getStylePackage(), &viewer().getLocalPackage(), ASPECT_BORDER, true))
-		: wxImage();
+	// don't use operator [], this can run on several worker threads at once
+	map<String,ScriptableImage>::const_iterator it = s.choice_images.find(name);
+	if (it == s.choice_images.end() || !it->second.isReady()) return wxImage();
+	return it->second.generate(GeneratedImage::Options(16,16, &viewer().getStylePackage(), &viewer().getLocalPackage(), ASPECT_BORDER, true));
 }
 
 void ChoiceThumbnailRequest::store(const Image& img) {
@@ -190,6 +191,11 @@ void DropDownChoiceListBase::generateThumbnailImages() {
 			}
 		}
 	}
+	// the images of the items in this list are visible, the ones in sub menus are not (yet)
+	set<int> visible_ids;
+	for (size_t item = 0 ; item < itemCount() ; ++item) {
+		if (!isFieldDefault(item)) visible_ids.insert(getChoice(item)->first_id);
+	}
 	// request thumbnails
 	style().thumbnails_status.resize(end, THUMB_NOT_MADE);
 	for (int i = 0 ; i < end ; ++i) {
@@ -204,7 +210,8 @@ void DropDownChoiceListBase::generateThumbnailImages() {
 			} else if (img.isReady()) {
 				// request this thumbnail
 				thumbnail_thread.request( intrusive(new ChoiceThumbnailRequest(
-						&cve, i, status == THUMB_NOT_MADE && !img.local(), img.threadSafe()
+						&cve, i, status == THUMB_NOT_MADE && !img.local(), img.threadSafe(),
+						visible_ids.count(i) ? THUMBNAIL_PRIORITY_VISIBLE : THUMBNAIL_PRIORITY_LOW
 					)));
 			}
 		}
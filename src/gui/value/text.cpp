@@ -1094,27 +1094,28 @@ Movement direction_of(size_t a, size_t b) {
 
 void TextValueEditor::fixSelection(IndexType t, Movement dir) {
 	const String& val = value().value->toString();
+	CursorPositions positions(val);
 	// Which type takes precedent?
 	if (t == TYPE_INDEX) {
-		selection_start = index_to_cursor(val, selection_start_i, dir);
-		selection_end   = index_to_cursor(val, selection_end_i,   dir);
+		selection_start = positions.indexToCursor(selection_start_i, dir);
+		selection_end   = positions.indexToCursor(selection_end_i,   dir);
 	}
 	// make sure the selection is at a valid position inside the text
 	// prepare to move 'inward' (i.e. from start in the direction of end and vice versa)
-	selection_start_i = cursor_to_index(val, selection_start, direction_of(selection_end, selection_start));
-	selection_end_i   = cursor_to_index(val, selection_end,   direction_of(selection_start, selection_end));
+	selection_start_i = positions.cursorToIndex(selection_start, direction_of(selection_end, selection_start));
+	selection_end_i   = positions.cursorToIndex(selection_end,   direction_of(selection_start, selection_end));
 	// start and end must be on the same side of separators
 	size_t seppos = val.find(_("<sep"));
 	while (seppos != String::npos) {
 		size_t sepend = match_close_tag_end(val, seppos);
 		if (selection_start_i <= seppos && selection_end_i > seppos) {
 		    // not on same side, move selection end before sep
-			selection_end   = index_to_cursor(val, seppos, dir);
-			selection_end_i = cursor_to_index(val, selection_end, direction_of(selection_start, selection_end));
+			selection_end   = positions.indexToCursor(seppos, dir);
+			selection_end_i = positions.cursorToIndex(selection_end, direction_of(selection_start, selection_end));
 		} else if (selection_start_i >= sepend && selection_end_i < sepend) {
 		    // not on same side, move selection end after sep
-			selection_end   = index_to_cursor(val, sepend, dir);
-			selection_end_i = cursor_to_index(val, selection_end, direction_of(selection_start, selection_end));
+			selection_end   = positions.indexToCursor(sepend, dir);
+			selection_end_i = positions.cursorToIndex(selection_end, direction_of(selection_start, selection_end));
 		}
 		// find next separator
 		seppos = val.find(_("<sep"), seppos + 1);
@@ -1196,12 +1197,6 @@ size_t TextValueEditor::move(size_t pos, size_t start, size_t end, Movement dir)
 
 // ----------------------------------------------------------------------------- : Search / replace
 
-bool is_word_end(const String& s, size_t pos) {
-	if (pos == 0 || pos >= s.size()) return true;
-	Char c = s.GetChar(pos);
-	return isSpace(c) || isPunct(c);
-}
-
 // is find.findString() at postion pos of s
 bool TextValueEditor::matchSubstr(const String& s, size_t pos, FindInfo& find) {
 	if (pos >= s.size()) return false;
@@ -1219,9 +1214,9 @@ bool TextValueEditor::matchSubstr(const String& s, size_t pos, FindInfo& find) {
 		editor().select(this);
 		editor().SetFocus();
 		size_t old_sel_start = selection_start, old_sel_end = selection_end;
-		String val = value().value->toString();
-		selection_start_i = untagged_to_index(val, pos,                            true);
-		selection_end_i   = untagged_to_index(val, pos + find.findString().size(), true);
+		TaggedPositions positions(value().value->toString());
+		selection_start_i = positions.untaggedToIndex(pos,                            true);
+		selection_end_i   = positions.untaggedToIndex(pos + find.findString().size(), true);
 		fixSelection(TYPE_INDEX);
 		was_selection = old_sel_start == selection_start && old_sel_end == selection_end;
 	}
@@ -1237,8 +1232,9 @@ bool TextValueEditor::search(FindInfo& find, bool from_start) {
 	String val = value().value->toString();
 	String v = untag(val);
 	if (!find.caseSensitive()) v.LowerCase();
-	size_t selection_min = index_to_untagged(val, min(selection_start_i, selection_end_i));
-	size_t selection_max = index_to_untagged(val, max(selection_start_i, selection_end_i));
+	TaggedPositions positions(val);
+	size_t selection_min = positions.indexToUntagged(min(selection_start_i, selection_end_i));
+	size_t selection_max = positions.indexToUntagged(max(selection_start_i, selection_end_i));
 	if (find.forward()) {
 		size_t start = min(v.size(), find.searchSelection() ? selection_min : selection_max);
 		for (size_t i = start ; i + find.findString().size() <= v.size() ; ++i) {
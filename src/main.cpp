@@ -9,6 +9,7 @@
 #include <util/prec.hpp>
 #include <util/io/package_manager.hpp>
 #include <util/spell_checker.hpp>
+#include <script/script_manager.hpp>
 #include <data/game.hpp>
 #include <data/set.hpp>
 #include <data/settings.hpp>
@@ -187,12 +188,17 @@ int MSE::OnRun() {
 					cli << _("\n\n  ") << BRIGHT << _("--cli") << NORMAL << _(" [")
 									   << BRIGHT << _("--quiet") << NORMAL << _("] [")
 									   << BRIGHT << _("--raw") << NORMAL << _("] [")
+									   << BRIGHT << _("--test") << NORMAL << _("] [")
 									   << BRIGHT << _("--script ") << NORMAL << PARAM << _("FILE") << NORMAL << _("] [")
+									   << BRIGHT << _("--server ") << NORMAL << PARAM << _("SOCKET") << NORMAL << _("] [")
 									   << PARAM << _("SETFILE") << NORMAL << _("]");
 					cli << _("\n         \tStart the command line interface for performing commands on the set file.");
 					cli << _("\n         \tUse ") << BRIGHT << _("-q") << NORMAL << _(" or ") << BRIGHT << _("--quiet") << NORMAL << _(" to supress the startup banner and prompts.");
 					cli << _("\n         \tUse ") << BRIGHT << _("--raw") << NORMAL << _(" for raw output mode.");
+					cli << _("\n         \tUse ") << BRIGHT << _("--test") << NORMAL << _(" to add functions for testing Magic Set Editor itself to scripts.");
 					cli << _("\n         \tUse ") << BRIGHT << _("--script") << NORMAL << _(" to execute a script file.");
+					cli << _("\n         \tUse ") << BRIGHT << _("--server") << NORMAL << _(" to keep running and answer raw mode commands from clients");
+					cli << _("\n         \tconnecting to a local socket, with the set and packages staying loaded.");
 					cli << _("\n\nRaw output mode is intended for use by other programs:");
 					cli << _("\n    - The only output is only in response to commands.");
 					cli << _("\n    - For each command a single 'record' is written to the standard output.");
@@ -213,7 +219,9 @@ int MSE::OnRun() {
 					// command line interface
 					SetP set;
 					vector<String> scripts;
+					String server;
 					bool quiet = false;
+					bool test_functions = false;
 					for (size_t i = 1 ; i < args.size() ; ++i) {
 						String const& arg = args[i];
 						wxFileName f(arg);
@@ -224,22 +232,30 @@ int MSE::OnRun() {
 						} else if (arg == _("-r") || arg == _("--raw")) {
 							quiet = true;
 							cli.enableRaw();
+						} else if (arg == _("--test")) {
+							test_functions = true;
 						} else if ((arg == _("-s") || arg == _("--script")) && i+1 < args.size()) {
 							scripts.push_back(args[i+1]);
 							++i;
+						} else if (arg == _("--server") && i+1 < args.size()) {
+							server = args[i+1];
+							quiet = true;
+							cli.enableRaw();
+							++i;
 						} else if (arg == _("--color")) {
 							// ignore
 						} else {
 							throw Error(_("Invalid command line argument: ") + arg);
 						}
 					}
-					CLISetInterface cli_interface(set,quiet);
-					if (scripts.empty()) {
+					CLISetInterface cli_interface(set,quiet,test_functions);
+					FOR_EACH(script, scripts) {
+						cli_interface.run_script_file(script);
+					}
+					if (!server.empty()) {
+						cli_interface.run_server(server);
+					} else if (scripts.empty()) {
 						cli_interface.run_interactive();
-					} else {
-						FOR_EACH(script, scripts) {
-							cli_interface.run_script_file(script);
-						}
 					}
 					return EXIT_SUCCESS;
 				} else if (args[0] == _("--export-images")) {
@@ -302,6 +318,7 @@ int MSE::runGUI() {
 int MSE::OnExit() {
 	thumbnail_thread.abortAll();
 	settings.write();
+	dependency_cache.save();
 	package_manager.destroy();
 	SpellChecker::destroyAll();
 	return 0;
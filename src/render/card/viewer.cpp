@@ -17,6 +17,7 @@
 #include <data/action/value.hpp>
 #include <data/action/set.hpp>
 #include <gui/util.hpp> // clearDC
+#include <script/profiler.hpp>
 
 DECLARE_TYPEOF_COLLECTION(ValueViewerP);
 DECLARE_TYPEOF_NO_REV(IndexMap<FieldP COMMA StyleP>);
@@ -38,6 +39,7 @@ void DataViewer::draw(DC& dc) {
 }
 void DataViewer::draw(RotatedDC& dc, const Color& background) {
 	if (!set) return; // no set specified, don't draw anything
+	PROFILER_STAGE(PROFILE_RENDER, _("draw card"));
 	WITH_DYNAMIC_ARG(drawing_card, true);
 	// fill with background color
 	clearDC(dc.getDC(), background);
@@ -204,6 +206,13 @@ ValueViewerP DataViewer::makeViewer(const StyleP& style) {
 	return style->makeViewer(*this);
 }
 
+bool DataViewer::listensTo(const Action& action) const {
+	return is_action<DisplayChangeAction>(action)
+	    || is_action<ValueAction>(action)
+	    || is_action<MultipleValueAction>(action)
+	    || is_action<ScriptValueEvent>(action);
+}
+
 void DataViewer::onAction(const Action& action, bool undone) {
 	TYPE_CASE_(action, DisplayChangeAction) {
 		// refresh
@@ -222,6 +231,22 @@ void DataViewer::onAction(const Action& action, bool undone) {
 			}
 		}
 	}
+	TYPE_CASE(action, MultipleValueAction) {
+		bool changed = false;
+		FOR_EACH_CONST(a, action.actions) {
+			if (a->card != card.get()) continue;
+			FOR_EACH(v, viewers) {
+				if (v->getValue()->equals( a->valueP.get() )) {
+					// refresh the viewer
+					v->onAction(*a, undone);
+					changed = true;
+					break;
+				}
+			}
+		}
+		if (changed) onChange();
+		return;
+	}
 	TYPE_CASE(action, ScriptValueEvent) {
 		if (action.card == card.get()) {
 			FOR_EACH(v, viewers) {
@@ -90,6 +90,7 @@ class DataViewer : public SetView {
 	
 	/// Update the viewers and forward actions
 	virtual void onAction(const Action&, bool undone);
+	virtual bool listensTo(const Action&) const;
 	
 	/// Notification that the total image has changed
 	virtual void onChange() {}
@@ -25,29 +25,87 @@ void filter_symbol(Image& symbol, const SymbolFilter& filter) {
 		symbol.SetAlpha(alpha);
 	}
 	for (UInt y = 0 ; y < height ; ++y) {
-		for (UInt x = 0 ; x < width ; ++x) {
-			// Determine set
-			//  green           -> border or outside
-			//  green+red=white -> border
-			if (data[0] != data[2]) {
-				// yellow/blue = editing hint, leave alone
-			} else {
-				SymbolSet point = data[1] ? (data[0] ? SYMBOL_BORDER : SYMBOL_OUTSIDE) : SYMBOL_INSIDE;
-				// Call filter
-				AColor result = filter.color((double)x / width, (double)y / height, point);
-				// Store color
-				data[0]  = result.Red();
-				data[1]  = result.Green();
-				data[2]  = result.Blue();
-				alpha[0] = result.alpha;
-			}
-			// next
-			data  += 3;
-			alpha += 1;
+		filter.filterRow(data, alpha, width, (double)y / height);
+		data  += 3 * width;
+		alpha += width;
+	}
+}
+
+// ----------------------------------------------------------------------------- : Span kernels
+
+// Filters process a row at a time with a kernel, which avoids a virtual call and the construction
+// of a color object for each pixel. A kernel has the members
+//   inside(x, data, alpha)   store the color of the x-th pixel of the row, it is inside the symbol
+//   border(x, data, alpha)   store the color of the x-th pixel of the row, it is on the border
+
+/// Apply a span kernel to a row of a symbol-image
+template <typename Kernel>
+void filter_row(Byte* data, Byte* alpha, UInt width, const Kernel& kernel) {
+	for (UInt x = 0 ; x < width ; ++x, data += 3, ++alpha) {
+		// Determine set
+		//  green           -> border or outside
+		//  green+red=white -> border
+		if (data[0] != data[2]) {
+			// yellow/blue = editing hint, leave alone
+		} else if (!data[1]) {
+			kernel.inside(x, data, *alpha);
+		} else if (data[0]) {
+			kernel.border(x, data, *alpha);
+		} else {
+			// outside is transparent
+			data[0] = data[1] = data[2] = *alpha = 0;
 		}
 	}
 }
 
+/// Kernel for solid colors
+struct SolidFillKernel {
+	SolidFillKernel(const AColor& fill, const AColor& border) {
+		set(fill_rgba, fill);
+		set(border_rgba, border);
+	}
+	inline void inside(UInt, Byte* data, Byte& alpha) const { store(fill_rgba,   data, alpha); }
+	inline void border(UInt, Byte* data, Byte& alpha) const { store(border_rgba, data, alpha); }
+  private:
+	Byte fill_rgba[4], border_rgba[4];
+	
+	static void set(Byte* rgba, const AColor& c) {
+		rgba[0] = c.Red(); rgba[1] = c.Green(); rgba[2] = c.Blue(); rgba[3] = c.alpha;
+	}
+	static inline void store(const Byte* rgba, Byte* data, Byte& alpha) {
+		data[0] = rgba[0]; data[1] = rgba[1]; data[2] = rgba[2]; alpha = rgba[3];
+	}
+};
+
+/// Kernel for gradients, t(x) gives the time on the gradient of the x-th pixel
+/** Gives the same colors as lerp */
+template <typename T>
+struct GradientKernel {
+	GradientKernel(const Color& fill_1, const Color& fill_2, const Color& border_1, const Color& border_2, const T& t)
+		: t(t)
+	{
+		set(fill_base,   fill_delta,   fill_1,   fill_2);
+		set(border_base, border_delta, border_1, border_2);
+	}
+	inline void inside(UInt x, Byte* data, Byte& alpha) const { store(fill_base,   fill_delta,   t(x), data, alpha); }
+	inline void border(UInt x, Byte* data, Byte& alpha) const { store(border_base, border_delta, t(x), data, alpha); }
+  private:
+	int fill_base[3], fill_delta[3], border_base[3], border_delta[3];
+	T t;
+	
+	static void set(int* base, int* delta, const Color& a, const Color& b) {
+		base[0] = a.Red();   delta[0] = b.Red()   - a.Red();
+		base[1] = a.Green(); delta[1] = b.Green() - a.Green();
+		base[2] = a.Blue();  delta[2] = b.Blue()  - a.Blue();
+	}
+	static inline void store(const int* base, const int* delta, double t, Byte* data, Byte& alpha) {
+		data[0] = (Byte)static_cast<int>(base[0] + delta[0] * t);
+		data[1] = (Byte)static_cast<int>(base[1] + delta[1] * t);
+		data[2] = (Byte)static_cast<int>(base[2] + delta[2] * t);
+		alpha   = 255;
+	}
+};
+
 Image render_symbol(const SymbolP& symbol, const SymbolFilter& filter, double border_radius, int width, int height, bool edit_hints, bool allow_smaller) {
 	Image i = render_symbol(symbol, border_radius, width, height, edit_hints, allow_smaller);
 	filter_symbol(i, filter);
@@ -56,6 +114,20 @@ Image render_symbol(const SymbolP& symbol, const SymbolFilter& filter, double bo
 
 // ----------------------------------------------------------------------------- : SymbolFilter
 
+void SymbolFilter::filterRow(Byte* data, Byte* alpha, UInt width, double y) const {
+	for (UInt x = 0 ; x < width ; ++x, data += 3, ++alpha) {
+		if (data[0] != data[2]) continue; // editing hint, leave alone
+		SymbolSet point = data[1] ? (data[0] ? SYMBOL_BORDER : SYMBOL_OUTSIDE) : SYMBOL_INSIDE;
+		// Call filter
+		AColor result = color((double)x / width, y, point);
+		// Store color
+		data[0] = result.Red();
+		data[1] = result.Green();
+		data[2] = result.Blue();
+		*alpha  = result.alpha;
+	}
+}
+
 IMPLEMENT_REFLECTION_NO_SCRIPT(SymbolFilter) {
 	REFLECT_IF_NOT_READING {
 		String fill_type = fillType();
@@ -93,6 +165,10 @@ AColor SolidFillSymbolFilter::color(double x, double y, SymbolSet point) const {
 	else                             return AColor(0,0,0,0);
 }
 
+void SolidFillSymbolFilter::filterRow(Byte* data, Byte* alpha, UInt width, double) const {
+	filter_row(data, alpha, width, SolidFillKernel(fill_color, border_color));
+}
+
 bool SolidFillSymbolFilter::operator == (const SymbolFilter& that) const {
 	const SolidFillSymbolFilter* that2 = dynamic_cast<const SolidFillSymbolFilter*>(&that);
 	return that2 && fill_color   == that2->fill_color
@@ -114,6 +190,11 @@ AColor GradientSymbolFilter::color(double x, double y, SymbolSet point, const T*
 	else                             return AColor(0,0,0,0);
 }
 
+template <typename T>
+void GradientSymbolFilter::filterRow(Byte* data, Byte* alpha, UInt width, const T& t) const {
+	filter_row(data, alpha, width, GradientKernel<T>(fill_color_1, fill_color_2, border_color_1, border_color_2, t));
+}
+
 bool GradientSymbolFilter::equal(const GradientSymbolFilter& that) const {
 	return fill_color_1   == that.fill_color_1
 	    && fill_color_2   == that.fill_color_2
@@ -160,6 +241,24 @@ double LinearGradientSymbolFilter::t(double x, double y) const {
 	return min(1.,max(0.,t));
 }
 
+/// Time on a linear gradient along a row, the dot product is linear in x
+struct LinearGradientRow {
+	double base, step, len;
+	inline double operator () (UInt x) const {
+		double t = fabs(base + x * step) / len;
+		return min(1.,max(0.,t));
+	}
+};
+
+void LinearGradientSymbolFilter::filterRow(Byte* data, Byte* alpha, UInt width, double y) const {
+	LinearGradientRow row;
+	row.len  = sqr(end_x - center_x) + sqr(end_y - center_y);
+	if (row.len == 0) row.len = 1; // prevent div by 0
+	row.base = (y - center_y) * (end_y - center_y) - center_x * (end_x - center_x);
+	row.step = (end_x - center_x) / width;
+	GradientSymbolFilter::filterRow(data, alpha, width, row);
+}
+
 bool LinearGradientSymbolFilter::operator == (const SymbolFilter& that) const {
 	const LinearGradientSymbolFilter* that2 = dynamic_cast<const LinearGradientSymbolFilter*>(&that);
 	return that2 && equal(*that2)
@@ -185,6 +284,21 @@ double RadialGradientSymbolFilter::t(double x, double y) const {
 	return sqrt( (sqr(x - 0.5) + sqr(y - 0.5)) * 2); 
 }
 
+/// Time on a radial gradient along a row
+struct RadialGradientRow {
+	double dy2, scale;
+	inline double operator () (UInt x) const {
+		return sqrt( (sqr(x * scale - 0.5) + dy2) * 2);
+	}
+};
+
+void RadialGradientSymbolFilter::filterRow(Byte* data, Byte* alpha, UInt width, double y) const {
+	RadialGradientRow row;
+	row.dy2   = sqr(y - 0.5);
+	row.scale = 1.0 / width;
+	GradientSymbolFilter::filterRow(data, alpha, width, row);
+}
+
 bool RadialGradientSymbolFilter::operator == (const SymbolFilter& that) const {
 	const RadialGradientSymbolFilter* that2 = dynamic_cast<const RadialGradientSymbolFilter*>(&that);
 	return that2 && equal(*that2);
@@ -43,6 +43,11 @@ class SymbolFilter : public IntrusivePtrVirtualBase {
 	/// What color should the symbol have at location (x, y)?
 	/** x,y are in the range [0...1) */
 	virtual AColor color(double x, double y, SymbolSet point) const = 0;
+	/// Filter a single row of a symbol-image, see filter_symbol
+	/** y is in the range [0...1), data and alpha point to the start of the row.
+	 *  The default implementation calls color for each pixel.
+	 */
+	virtual void filterRow(Byte* data, Byte* alpha, UInt width, double y) const;
 	/// Name of this fill type
 	virtual String fillType() const = 0;
 	/// Comparision
@@ -66,6 +71,7 @@ class SolidFillSymbolFilter : public SymbolFilter {
 		: fill_color(fill_color), border_color(border_color)
 	{}
 	virtual AColor color(double x, double y, SymbolSet point) const;
+	virtual void filterRow(Byte* data, Byte* alpha, UInt width, double y) const;
 	virtual String fillType() const;
 	virtual bool operator == (const SymbolFilter& that) const;
   private:
@@ -86,6 +92,9 @@ class GradientSymbolFilter : public SymbolFilter {
 	Color fill_color_2, border_color_2;
 	template <typename T>
 	AColor color(double x, double y, SymbolSet point, const T* t) const;
+	/// Filter a row, t(x) gives the time on the gradient for the x-th pixel
+	template <typename T>
+	void filterRow(Byte* data, Byte* alpha, UInt width, const T& t) const;
 	bool equal(const GradientSymbolFilter& that) const;
 	
 	DECLARE_REFLECTION();
@@ -99,6 +108,7 @@ class LinearGradientSymbolFilter : public GradientSymbolFilter {
 	                          ,double center_x, double center_y, double end_x, double end_y);
 	
 	virtual AColor color(double x, double y, SymbolSet point) const;
+	virtual void filterRow(Byte* data, Byte* alpha, UInt width, double y) const;
 	virtual String fillType() const;
 	virtual bool operator == (const SymbolFilter& that) const;
 	
@@ -121,6 +131,7 @@ class RadialGradientSymbolFilter : public GradientSymbolFilter {
 	{}
 	
 	virtual AColor color(double x, double y, SymbolSet point) const;
+	virtual void filterRow(Byte* data, Byte* alpha, UInt width, double y) const;
 	virtual String fillType() const;
 	virtual bool operator == (const SymbolFilter& that) const;
 	
@@ -8,6 +8,7 @@
 
 #include <util/prec.hpp>
 #include <render/text/viewer.hpp>
+#include <script/profiler.hpp>
 #include <algorithm>
 
 DECLARE_TYPEOF_COLLECTION(TextViewer::Line);
@@ -157,6 +158,7 @@ void TextViewer::drawSeparators(RotatedDC& dc) {
 bool TextViewer::prepare(RotatedDC& dc, const String& text, TextStyle& style, Context& ctx) {
 	if (!prepared()) {
 		// not prepared yet
+		PROFILER_STAGE(PROFILE_LAYOUT, _("layout text"));
 		prepareElements(text, style, ctx);
 		prepareLines(dc, text, style, ctx);
 		return true;
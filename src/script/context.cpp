@@ -41,6 +41,9 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
 	
 	size_t stack_size = stack.size();
 	size_t scope = useScope ? openScope() : 0;
+	// Scope for the arguments of the function call currently in progress, if any
+	bool   in_call    = false;
+	size_t call_scope = 0;
 	try {
 		// Instruction pointer
 		const Instruction* instr = &script.instructions[0];
@@ -50,8 +53,6 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
 		while (instr < end) {
 			// Evaluate the current instruction
 			Instruction i = *instr++;
-			// If a scope is created, destroy it at end of block.
-			scoped_ptr<LocalScope> new_scope;
 
 			switch (i.instr) {
 				case I_NOP: break;
@@ -109,7 +110,7 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
 				
 				// Get an object member
 				case I_MEMBER_C: {
-					stack.back() = stack.back()->getMember(script.constants[i.data]->toString());
+					stack.back() = stack.back()->getMember(script.members[i.data]);
 					break;
 				}
 				// Loop over a container, push next value or jump
@@ -146,8 +147,12 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
 				
 				// Function call
 				case I_CALL:
-					new_scope.reset(new LocalScope(*this)); //new scope
 				case I_TAILCALL: {
+					// a normal call gets a new scope for its arguments, a tail call reuses ours
+					if (i.instr == I_CALL) {
+						call_scope = openScope();
+						in_call    = true;
+					}
 					// prepare arguments
 					for (unsigned int j = 0 ; j < i.data ; ++j) {
 						setVariable((Variable)instr[i.data - j - 1].data, stack.back());
@@ -188,6 +193,10 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
 							throw e; // rethrow
 						}
 					}
+					if (in_call) {
+						closeScope(call_scope);
+						in_call = false;
+					}
 					break;
 				}
 				
@@ -251,6 +260,7 @@ ScriptValueP Context::eval(const Script& script, bool useScope) {
 		
 	} catch (...) {
 		// cleanup after an exception
+		if (in_call)  closeScope(call_scope);
 		if (useScope) closeScope(scope); // restore scope
 		stack.resize(stack_size);     // restore stack
 		throw; // rethrow
@@ -271,9 +281,12 @@ void Context::setVariable(Variable name, const ScriptValueP& value) {
 	#endif
 	VariableValue& var = variables[name];
 	if (var.level < level) {
-		// keep shadow copy
-		Binding bind = {name, var};
-		shadowed.push_back(bind);
+		// keep shadow copy, move the old value instead of copying the reference
+		shadowed.resize(shadowed.size() + 1);
+		Binding& bind = shadowed.back();
+		bind.variable    = name;
+		bind.value.level = var.level;
+		swap(bind.value.value, var.value);
 	}
 	var.level = level;
 	var.value = value;
@@ -352,7 +365,10 @@ void Context::closeScope(size_t scope) {
 	#endif
 	// restore shadowed variables
 	while (shadowed.size() > scope) {
-		variables[shadowed.back().variable] = shadowed.back().value;
+		Binding& bind = shadowed.back();
+		VariableValue& var = variables[bind.variable];
+		var.level = bind.value.level;
+		swap(var.value, bind.value.value);
 		shadowed.pop_back();
 	}
 }
@@ -227,7 +227,7 @@ ScriptValueP Context::dependencies(const Dependency& dep, const Script& script)
 				
 				// Get an object member (almost as normal)
 				case I_MEMBER_C: {
-					String name = script.constants[i.data]->toString();
+					const String& name = script.members[i.data].name;
 					stack.back() = stack.back()->dependencyMember(name, dep); // dependency on member
 					break;
 				}
@@ -22,6 +22,7 @@ enum DependencyType
 ,	DEP_EXTRA_CARD_FIELD	///< dependency of a script in an extra stylesheet specific card field
 ,	DEP_CARD_COPY_DEP		///< copy the dependencies from a card field
 ,	DEP_SET_COPY_DEP		///< copy the dependencies from a set  field
+,	DEP_ORDER_CACHE			///< dependency of an order_by or filter script of position_of/length, the set's order cache needs updating
 ,	DEP_DUMMY				///< used for other purposes, index and data can be anything
 							//   in particular, this is used for determining /if/ there are dependencies
 };
@@ -49,16 +50,30 @@ class Dependency {
 
 // ----------------------------------------------------------------------------- : Dependencies
 
+class Dependencies;
+
+/// Something that wants to know about all dependencies that are added, see DependencyCache
+class DependencyRecorder {
+  public:
+	virtual ~DependencyRecorder() {}
+	/// A dependency is added to a list
+	virtual void record(const Dependencies& target, const Dependency& dep) = 0;
+};
+
 /// A list of dependencies
 class Dependencies : public vector<Dependency> {
   public:
 	/// Add a dependency, prevents duplicates
 	inline void add(const Dependency& d) {
 		if (d.type == DEP_DUMMY) return;
+		if (recorder) recorder->record(*this, d);
 		if (find(begin(),end(),d) == end()) {
 			push_back(d);
 		}
 	}
+	
+	/// Is told about all dependencies that are added to any list, or nullptr
+	static DependencyRecorder* recorder;
   private:
 	using vector<Dependency>::push_back;
 };
@@ -444,6 +444,17 @@ SCRIPT_FUNCTION(remove_tags) {
 	SCRIPT_RETURN(untag_no_escape(input));
 }
 
+// Replace all occurences of a string in the text, ignoring tags, like "Replace all" in the editor
+SCRIPT_FUNCTION(find_replace) {
+	SCRIPT_PARAM_C(String, input);
+	SCRIPT_PARAM_C(String, match);
+	SCRIPT_PARAM_C(String, replace);
+	SCRIPT_PARAM_DEFAULT(bool, case_sensitive, true);
+	SCRIPT_PARAM_DEFAULT(bool, whole_word, false);
+	assert_tagged(input, false);
+	SCRIPT_RETURN(tagged_replace_all(input, match, replace, case_sensitive, whole_word));
+}
+
 // ----------------------------------------------------------------------------- : Collection stuff
 
 
@@ -525,6 +536,16 @@ SCRIPT_FUNCTION_WITH_DEP(position_of) {
 	if (filter == script_nil) filter = ScriptValueP();
 	SCRIPT_RETURN(position_in_vector(of, in, order_by, filter));
 }
+/// Mark the dependencies of an order_by or filter function applied to all cards of a set
+void mark_order_dependencies(Context& ctx, const ScriptValueP& fun, const Dependency& dep) {
+	// the result depends on the function for all cards
+	fun->dependencies(ctx, dep.makeCardIndependend());
+	// the order cache of the set must be updated when one card changes
+	if (dep.type != DEP_DUMMY) {
+		fun->dependencies(ctx, Dependency(DEP_ORDER_CACHE, 0));
+	}
+}
+
 SCRIPT_FUNCTION_DEPENDENCIES(position_of) {
 	ScriptValueP of       = ctx.getVariable(_("of"));
 	ScriptValueP in       = ctx.getVariable(_("in"));
@@ -537,11 +558,11 @@ SCRIPT_FUNCTION_DEPENDENCIES(position_of) {
 		mark_dependency_member(*s->getValue(), _("cards"), dep);
 		if (order_by) {
 			// dependency on order_by function
-			order_by->dependencies(ctx, dep.makeCardIndependend());
+			mark_order_dependencies(ctx, order_by, dep);
 		}
 		if (filter && filter != script_nil) {
 			// dependency on filter function
-			filter->dependencies(ctx, dep.makeCardIndependend());
+			mark_order_dependencies(ctx, filter, dep);
 		}
 	}
 	return dependency_dummy;
@@ -557,14 +578,32 @@ int script_length_of(Context& ctx, const ScriptValueP& collection) {
 		return collection->itemCount();
 	}
 }
-SCRIPT_FUNCTION(length) {
+ScriptValueP script_length_of_dependencies(Context& ctx, const ScriptValueP& collection, const Dependency& dep) {
+	if (ScriptObject<Set*>* setobj = dynamic_cast<ScriptObject<Set*>*>(collection.get())) {
+		// dependency on cards
+		mark_dependency_member(*setobj->getValue(), _("cards"), dep);
+		ScriptValueP filter = ctx.getVariableOpt(SCRIPT_VAR_filter);
+		if (filter && filter != script_nil) {
+			// dependency on filter function
+			mark_order_dependencies(ctx, filter, dep);
+		}
+	}
+	return dependency_dummy;
+}
+SCRIPT_FUNCTION_WITH_DEP(length) {
 	SCRIPT_PARAM_C(ScriptValueP, input);
 	SCRIPT_RETURN(script_length_of(ctx, input));
 }
-SCRIPT_FUNCTION(number_of_items) {
+SCRIPT_FUNCTION_DEPENDENCIES(length) {
+	return script_length_of_dependencies(ctx, ctx.getVariable(SCRIPT_VAR_input), dep);
+}
+SCRIPT_FUNCTION_WITH_DEP(number_of_items) {
 	SCRIPT_PARAM_C(ScriptValueP, in);
 	SCRIPT_RETURN(script_length_of(ctx, in));
 }
+SCRIPT_FUNCTION_DEPENDENCIES(number_of_items) {
+	return script_length_of_dependencies(ctx, ctx.getVariable(SCRIPT_VAR_in), dep);
+}
 
 // filtering items from a list
 SCRIPT_FUNCTION(filter_list) {
@@ -769,6 +808,7 @@ void init_script_basic_functions(Context& ctx) {
 	ctx.setVariable(_("replace_tag_contents"), script_replace_tag_contents);
 	ctx.setVariable(_("remove_tag"),           script_remove_tag);
 	ctx.setVariable(_("remove_tags"),          script_remove_tags);
+	ctx.setVariable(_("find_replace"),         script_find_replace);
 	ctx.setVariable(_("tag_contents_rule"),    intrusive(new ScriptRule(script_replace_tag_contents))); // compatability
 	ctx.setVariable(_("tag_remove_rule"),      intrusive(new ScriptRule(script_remove_tag))); // compatability
 	// collection
@@ -401,6 +401,16 @@ SCRIPT_FUNCTION(write_text_file) {
 	SCRIPT_RETURN(file);
 }
 
+/// The image type to use for a file, based on its extension, wxBITMAP_TYPE_INVALID if there is no handler for it
+int image_type_for_file(const String& filename) {
+	String ext = wxFileName(filename).GetExt();
+	for (wxList::compatibility_iterator node = wxImage::GetHandlers().GetFirst() ; node ; node = node->GetNext()) {
+		wxImageHandler* handler = (wxImageHandler*)node->GetData();
+		if (ext.IsSameAs(handler->GetExtension(), false)) return handler->GetType();
+	}
+	return wxBITMAP_TYPE_INVALID;
+}
+
 SCRIPT_FUNCTION(write_image_file) {
 	guard_export_info(_("write_image_file"));
 	// output path
@@ -424,8 +434,13 @@ SCRIPT_FUNCTION(write_image_file) {
 		image = input->toImage()->generateConform(options);
 	}
 	if (!image.Ok()) throw Error(_("Unable to generate image for file ") + file);
-	// write
-	image.SaveFile(out_path);
+	// write, encoding happens in the background, the export waits for it to finish
+	int type = image_type_for_file(out_path);
+	if (type != wxBITMAP_TYPE_INVALID) {
+		ei.image_writer.write(image, out_path, type);
+	} else {
+		image.SaveFile(out_path); // unknown type, let wx complain
+	}
 	ei.exported_images.insert(make_pair(file, wxSize(image.GetWidth(), image.GetHeight())));
 	SCRIPT_RETURN(file);
 }
@@ -11,6 +11,7 @@
 #include <script/functions/util.hpp>
 #include <util/regex.hpp>
 #include <util/error.hpp>
+#include <wx/thread.h>
 
 DECLARE_POINTER_TYPE(ScriptRegex);
 DECLARE_TYPEOF_COLLECTION(pair<Variable COMMA ScriptValueP>);
@@ -48,12 +49,40 @@ class ScriptRegex : public ScriptValue, public Regex {
 	using Regex::matches;
 };
 
+// ----------------------------------------------------------------------------- : Regex cache
+
+/// Maximum number of compiled regular expressions to keep in the cache
+const size_t MAX_REGEX_CACHE_SIZE = 1000;
+
+/// Cache of compiled regular expressions, shared by all scripts and threads
+/** Patterns that are built at runtime are usually the same for many calls, so they only have to be compiled once.
+ */
+class RegexCache {
+  public:
+	ScriptRegexP get(const String& code) {
+		{
+			wxMutexLocker lock(mutex);
+			map<String,ScriptRegexP>::const_iterator it = cache.find(code);
+			if (it != cache.end()) return it->second;
+		}
+		// compile outside the lock, this can throw
+		ScriptRegexP regex = intrusive(new ScriptRegex(code));
+		wxMutexLocker lock(mutex);
+		if (cache.size() >= MAX_REGEX_CACHE_SIZE) cache.clear();
+		cache.insert(make_pair(code, regex));
+		return regex;
+	}
+  private:
+	wxMutex mutex;
+	map<String,ScriptRegexP> cache;
+};
+RegexCache regex_cache;
+
 ScriptRegexP regex_from_script(const ScriptValueP& value) {
 	// is it a regex already?
 	ScriptRegexP regex = dynamic_pointer_cast<ScriptRegex>(value);
 	if (!regex) {
-		// TODO: introduce some kind of caching?
-		regex = intrusive(new ScriptRegex(value->toString()));
+		regex = regex_cache.get(value->toString());
 	}
 	return regex;
 }
@@ -14,15 +14,70 @@
 #include <util/tagged_string.hpp>
 #include <data/stylesheet.hpp>
 
+// ----------------------------------------------------------------------------- : Tag ranges
+
+/// Answers is_in_tag(input,tag,start,end) for many words, using a single pass over the input.
+/** is_in_tag itself scans from the start of the input, so using it for every word takes quadratic time.
+ */
+class TagRanges {
+  public:
+	TagRanges(const String& input, const String& tag)
+		: input(input), tag(tag), any(input.find(tag) != String::npos)
+	{
+		if (!any) return;
+		// walk over the input like in_tag does, remember at which positions we are not inside the tag
+		size_t size = input.size();
+		vector<bool> outside(size + 1, false);
+		boundary.resize(size + 1, false);
+		int taglevel = 0;
+		for (size_t pos = 0 ; pos < size ; ) {
+			Char c = input.GetChar(pos);
+			if (c == _('<')) {
+				if (is_substr(input, pos + 1, static_cast<const Char*>(tag.c_str())+1)) {
+					++taglevel;
+				} else if (pos + 2 < size && input.GetChar(pos+1) == _('/') && is_substr(input, pos + 2, static_cast<const Char*>(tag.c_str())+1)) {
+					--taglevel; // close tag
+				}
+				pos = min(skip_tag(input,pos), size);
+			} else {
+				pos++;
+			}
+			boundary[pos] = true;
+			outside[pos]  = taglevel < 1;
+		}
+		outside_before.resize(size + 2, 0);
+		for (size_t i = 0 ; i <= size ; ++i) {
+			outside_before[i+1] = outside_before[i] + (outside[i] ? 1 : 0);
+		}
+	}
+	
+	/// Is the range [start...end) inside the tag? Same as is_in_tag(input,tag,start,end).
+	bool inside(size_t start, size_t end) const {
+		if (!any) return false;
+		if (start >= end) return is_in_tag(input,tag,start,end);
+		// in_tag stops at the first position >= end that it reaches
+		end = min(end, input.size());
+		while (!boundary[end]) ++end;
+		return outside_before[end+1] == outside_before[start];
+	}
+	
+  private:
+	const String& input;
+	const String  tag;
+	bool          any;            ///< Does the tag occur in the input at all?
+	vector<bool>  boundary;       ///< Positions in the input that are not inside a <tag>
+	vector<UInt>  outside_before; ///< outside_before[i] = number of boundaries before i where we are not in the tag
+};
+
 // ----------------------------------------------------------------------------- : Functions
 
-inline size_t spelled_correctly(const String& input, size_t start, size_t end, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx) {
+inline size_t spelled_correctly(const String& input, size_t start, size_t end, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx, const TagRanges& in_sym, const TagRanges& in_nospellcheck) {
 	// untag
 	String word = untag(input.substr(start,end-start));
 	if (word.empty()) return true;
 	// symbol?
-	if (is_in_tag(input,_("<sym"),start,end) ||
-		is_in_tag(input,_("<nospellcheck"),start,end)) {
+	if (in_sym.inside(start,end) ||
+		in_nospellcheck.inside(start,end)) {
 		// symbols are always spelled correctly
 		// and <nospellcheck> tags should prevent spellcheck
 		return true;
@@ -49,15 +104,15 @@ inline size_t spelled_correctly(const String& input, size_t start, size_t end, S
 	return false;
 }
 
-void check_word(const String& tag, const String& input, String& out, size_t start, size_t end, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx) {
+void check_word(const String& tag, const String& input, String& out, size_t start, size_t end, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx, const TagRanges& in_sym, const TagRanges& in_nospellcheck) {
 	if (start >= end) return;
-	bool good = spelled_correctly(input, start, end, checkers, extra_test, ctx);
+	bool good = spelled_correctly(input, start, end, checkers, extra_test, ctx, in_sym, in_nospellcheck);
 	if (!good) out += _("<") + tag;
 	out.append(input, start, end-start);
 	if (!good) out += _("</") + tag;
 }
 
-void check_word(const String& tag, const String& input, String& out, Char sep, size_t prev, size_t start, size_t end, size_t after, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx) {
+void check_word(const String& tag, const String& input, String& out, Char sep, size_t prev, size_t start, size_t end, size_t after, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx, const TagRanges& in_sym, const TagRanges& in_nospellcheck) {
 	if (start == end) {
 		// word consisting of whitespace/punctuation only
 		if (untag(input.substr(prev,after-prev)).empty()) {
@@ -83,7 +138,7 @@ void check_word(const String& tag, const String& input, String& out, Char sep, s
 		if (sep) out.append(sep);
 		out.append(input, prev, start-prev);
 		// the word itself
-		check_word(tag, input, out, start, end, checkers, extra_test, ctx);
+		check_word(tag, input, out, start, end, checkers, extra_test, ctx, in_sym, in_nospellcheck);
 		// after the word
 		out.append(input, end, after-end);
 	}
@@ -116,6 +171,9 @@ SCRIPT_FUNCTION(check_spelling) {
 		tag += _(":") + extra_dictionary;
 	}
 	tag += _(">");
+	// symbols are always spelled correctly, and <nospellcheck> tags should prevent spellcheck
+	TagRanges in_sym(input, _("<sym"));
+	TagRanges in_nospellcheck(input, _("<nospellcheck"));
 	// now walk over the words in the input, and mark misspellings
 	String result;
 	Char sep = 0;
@@ -138,7 +196,7 @@ SCRIPT_FUNCTION(check_spelling) {
 			}
 		} else if (isSpace(c) || c == EM_DASH || c == EN_DASH) {
 			// word boundary => check the word
-			check_word(tag, input, result, sep, prev_end, word_start, word_end, pos, checkers, extra_match, ctx);
+			check_word(tag, input, result, sep, prev_end, word_start, word_end, pos, checkers, extra_match, ctx, in_sym, in_nospellcheck);
 			// next
 			sep = c;
 			prev_end = word_start = word_end = pos = pos + 1;
@@ -155,7 +213,7 @@ SCRIPT_FUNCTION(check_spelling) {
 		}
 	}
 	// last word
-	check_word(tag, input, result, sep, prev_end, word_start, word_end, pos, checkers, extra_match, ctx);
+	check_word(tag, input, result, sep, prev_end, word_start, word_end, pos, checkers, extra_match, ctx, in_sym, in_nospellcheck);
 	// done
 	assert_tagged(result);
 	SCRIPT_RETURN(result);
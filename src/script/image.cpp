@@ -10,6 +10,7 @@
 #include <script/image.hpp>
 #include <script/context.hpp>
 #include <script/to_value.hpp>
+#include <script/profiler.hpp>
 #include <util/dynamic_arg.hpp>
 #include <util/io/package.hpp>
 #include <gfx/generated_image.hpp>
@@ -132,6 +133,7 @@ void CachedScriptableImage::generateCached(const GeneratedImage::Options& option
 			}
 		}
 	}
+	PROFILER_STAGE(PROFILE_IMAGE, _("generate image"));
 	// hack(part1): temporarily set angle to 0, do actual rotation after applying mask
 	Radians a = options.angle;
 	const_cast<GeneratedImage::Options&>(options).angle = 0;
@@ -83,6 +83,8 @@ class TokenIterator {
 	String getSourceCode(size_t start, size_t end);
 	/// Get the current line number
 	int getLineNumber();
+	/// Hashes of the contents of the files that were included, empty if there were none
+	inline const String& getIncludedHash() const { return included_hash; }
 	
   private:
 	String input;
@@ -100,6 +102,7 @@ class TokenIterator {
 		Packaged* package;
 	};
 	stack<MoreInput> more;		///< Read tokens from here when we are done with the current input
+	String included_hash;		///< Hashes of the included files
 	
 	/// Add a token to the buffer, with the current newline value, resets newline
 	void addToken(TokenType type, const String& value, size_t start);
@@ -206,6 +209,7 @@ void TokenIterator::readToken() {
 		filename = include_file;
 		InputStreamP is = package_manager.openFileFromPackage(package, include_file);
 		input = read_utf8_line(*is, true, true);
+		included_hash += hash_string(input);
 	} else if (isAlpha(c) || c == _('_') || (isDigit(c) && !buffer.empty() && buffer.back() == _("."))) {
 		// name, or a number after a . token, as in array.0
 		size_t start = pos - 1;
@@ -404,6 +408,102 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence min_prec, In
 /// Parse call arguments, "(...)"
 void parseCallArguments(TokenIterator& input, Script& script, vector<Variable>& arguments);
 
+// ----------------------------------------------------------------------------- : Constant folding
+
+// Perform a unary simple instruction, store the result in a (not in *a)
+void instrUnary  (UnaryInstructionType   i, ScriptValueP& a);
+// Perform a binary simple instruction, store the result in a (not in *a)
+void instrBinary (BinaryInstructionType  i, ScriptValueP& a, const ScriptValueP& b);
+
+/// Is a value simple enough to compute with while parsing?
+bool is_simple_constant(const ScriptValueP& value) {
+	ScriptType t = value->type();
+	return t == SCRIPT_NIL    || t == SCRIPT_INT    || t == SCRIPT_BOOL
+	    || t == SCRIPT_DOUBLE || t == SCRIPT_STRING || t == SCRIPT_COLOR;
+}
+
+/// If the code from start onwards is a single constant, return it
+/** Code consisting of a single instruction can not contain jump targets,
+ *  so it is safe to replace.
+ */
+ScriptValueP constant_from(Script& script, size_t start) {
+	const vector<Instruction>& instrs = script.getInstructions();
+	if (instrs.size() == start + 1 && instrs.back().instr == I_PUSH_CONST) {
+		return script.getConstants()[instrs.back().data];
+	}
+	return ScriptValueP();
+}
+
+/// If the code from start onwards is a constant with a boolean value, return that value in value_out
+bool constant_condition(Script& script, size_t start, bool& value_out) {
+	ScriptValueP value = constant_from(script, start);
+	if (!value || !is_simple_constant(value)) return false;
+	try {
+		value_out = value->toBool();
+		return true;
+	} catch (const Error&) {
+		return false; // leave the error for run time
+	}
+}
+
+/// Remove the code from start onwards, and the constants that only it used
+void remove_code(Script& script, size_t start) {
+	vector<Instruction>&  instrs    = script.getInstructions();
+	vector<ScriptValueP>& constants = script.getConstants();
+	while (instrs.size() > start) {
+		if (instrs.back().instr == I_PUSH_CONST && instrs.back().data + 1 == constants.size()) {
+			constants.pop_back();
+		}
+		instrs.pop_back();
+	}
+}
+
+/// Evaluate the code from start onwards while parsing, if it is a simple instruction applied to constants
+/** Only unary and binary instructions without side effects are folded.
+ *  If evaluation fails the code is left alone, so the error still happens at run time.
+ */
+void fold_constants(Script& script, size_t start) {
+	const vector<Instruction>&  instrs    = script.getInstructions();
+	const vector<ScriptValueP>& constants = script.getConstants();
+	size_t count = instrs.size() - start;
+	if (count != 2 && count != 3) return;
+	for (size_t k = start ; k + 1 < instrs.size() ; ++k) {
+		if (instrs[k].instr != I_PUSH_CONST || !is_simple_constant(constants[instrs[k].data])) return;
+	}
+	Instruction  op = instrs.back();
+	ScriptValueP a  = constants[instrs[start].data];
+	try {
+		if (count == 2 && op.instr == I_UNARY && op.instr1 != I_ITERATOR_C) {
+			instrUnary(op.instr1, a);
+		} else if (count == 3 && op.instr == I_BINARY && op.instr2 != I_ITERATOR_R && op.instr2 != I_MEMBER) {
+			ScriptValueP b = constants[instrs[start + 1].data];
+			if ((op.instr2 == I_DIV || op.instr2 == I_MOD) &&
+			    a->type() != SCRIPT_DOUBLE && b->type() != SCRIPT_DOUBLE && b->toInt() == 0) {
+				return; // integer division by zero, leave it for run time
+			}
+			instrBinary(op.instr2, a, b);
+		} else {
+			return;
+		}
+	} catch (const Error&) {
+		return; // leave the error for run time
+	}
+	if (!is_simple_constant(a)) return;
+	remove_code(script, start);
+	script.addInstruction(I_PUSH_CONST, a);
+}
+
+/// Discard the result of the statement from start onwards
+void discard_result(Script& script, size_t start) {
+	if (constant_from(script, start)) {
+		remove_code(script, start); // a constant has no side effects, drop it entirely
+	} else {
+		script.addInstruction(I_POP);
+	}
+}
+
+// ----------------------------------------------------------------------------- : Parsing
+
 
 ScriptP parse(const String& s, Packaged* package, bool string_mode, vector<ScriptParseError>& errors_out) {
 	errors_out.clear();
@@ -419,6 +519,7 @@ ScriptP parse(const String& s, Packaged* package, bool string_mode, vector<Scrip
 	if (type == EXPR_FAILED) {
 		return ScriptP();
 	} else {
+		script->setIncludedHash(input.getIncludedHash());
 		return script;
 	}
 }
@@ -498,7 +599,24 @@ ExprType parseExpr(TokenIterator& input, Script& script, Precedence minPrec) {
 			script.addInstruction(I_PUSH_CONST, script_nil); // universal constant : nil
 		} else if (token == _("if")) {
 			// if AAA then BBB else CCC
+			size_t start = script.getInstructions().size();
 			parseOper(input, script, PREC_AND);							// AAA
+			bool condition;
+			if (constant_condition(script, start, condition)) {
+				// only one branch can be taken, the other is parsed into a scratch script and dropped
+				remove_code(script, start);
+				Script dead;
+				expectToken(input, _("then"));										// then
+				ExprType type1 = parseOper(input, condition ? script : dead, PREC_SET);	// BBB
+				ExprType type2 = EXPR_STATEMENT;
+				if (input.peek() == _("else")) {										// else
+					input.read();
+					type2 = parseOper(input, condition ? dead : script, PREC_SET);		// CCC
+				} else if (!condition) {
+					script.addInstruction(I_PUSH_CONST, script_nil);
+				}
+				return type1 == EXPR_STATEMENT || type2 == EXPR_STATEMENT ? EXPR_STATEMENT : EXPR_OTHER;
+			}
 			unsigned jmpElse = script.addInstruction(I_JUMP_IF_NOT);	//		jnz lbl_else
 			expectToken(input, _("then"));								// then
 			ExprType type1 = parseOper(input, script, PREC_SET);		// BBB
@@ -595,12 +713,14 @@ ExprType parseExpr(TokenIterator& input, Script& script, Precedence minPrec) {
 		} else if (token == _("min") || token == _("max")) {
 			// min(x,y,z,...)
 			unsigned int op = token == _("min") ? I_MIN : I_MAX;
+			size_t start = script.getInstructions().size();
 			expectToken(input, _("("));
 			parseOper(input, script, PREC_ALL); // first
 			while(input.peek() == _(",")) {
 				expectToken(input, _(","));
 				parseOper(input, script, PREC_ALL); // second, third, etc.
 				script.addInstruction(I_BINARY, op);
+				fold_constants(script, start);
 			}
 			expectToken(input, _(")"), &token);
 		} else if (token == _("assert")) {
@@ -661,6 +781,8 @@ ExprType parseExpr(TokenIterator& input, Script& script, Precedence minPrec) {
 }
 
 ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, InstructionType closeWith, int closeWithData) {
+	size_t start           = script.getInstructions().size();
+	size_t statement_start = start;
 	ExprType type = parseExpr(input, script, minPrec); // first argument
 	// read any operators after an expression
 	// EBNF:                    expr = expr | expr oper expr
@@ -680,7 +802,8 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 				// allow ; at end of expression without errors
 				break;
 			}
-			script.addInstruction(I_POP); // discard result of first expression
+			discard_result(script, statement_start); // discard result of first expression
+			statement_start = script.getInstructions().size();
 			type = parseOper(input, script, PREC_SET);
 		} else if (minPrec <= PREC_SET && token==_(":=")) {
 			// We made a mistake, the part before the := should be a variable name,
@@ -705,9 +828,21 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 			//   I_JUMP_SC_AND after     # if top==false then goto after else pop
 			//   YYY
 			//   after:
-			unsigned jmpSC = script.addInstruction(I_JUMP_SC_AND);
-			parseOper(input, script, PREC_CMP);
-			script.comeFrom(jmpSC);
+			bool left;
+			if (constant_condition(script, start, left)) {
+				// "true and YYY" is YYY, "false and YYY" is false
+				if (left) {
+					remove_code(script, start);
+					parseOper(input, script, PREC_CMP);
+				} else {
+					Script dead;
+					parseOper(input, dead, PREC_CMP);
+				}
+			} else {
+				unsigned jmpSC = script.addInstruction(I_JUMP_SC_AND);
+				parseOper(input, script, PREC_CMP);
+				script.comeFrom(jmpSC);
+			}
 		}
 		else if (minPrec <= PREC_AND    && token==_("or" )) {
 			Token t = input.peek();
@@ -717,9 +852,21 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 				parseOper(input, script, PREC_ADD, I_BINARY, I_OR_ELSE);
 			} else {
 				// short-circuiting or
-				unsigned jmpSC = script.addInstruction(I_JUMP_SC_OR);
-				parseOper(input, script, PREC_CMP);
-				script.comeFrom(jmpSC);
+				bool left;
+				if (constant_condition(script, start, left)) {
+					// "true or YYY" is true, "false or YYY" is YYY
+					if (left) {
+						Script dead;
+						parseOper(input, dead, PREC_CMP);
+					} else {
+						remove_code(script, start);
+						parseOper(input, script, PREC_CMP);
+					}
+				} else {
+					unsigned jmpSC = script.addInstruction(I_JUMP_SC_OR);
+					parseOper(input, script, PREC_CMP);
+					script.comeFrom(jmpSC);
+				}
 			}
 		}
 		else if (minPrec <= PREC_AND    && token==_("xor"))   parseOper(input, script, PREC_CMP,   I_BINARY, I_XOR);
@@ -761,7 +908,9 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 				//   MEMBER
 				// becomes
 				//   MEMBER_CONST x
-				script.getInstructions().back().instr = I_MEMBER_C;
+				ScriptValueP name = script.getConstants()[script.getInstructions().back().data];
+				script.getInstructions().pop_back();
+				script.addInstruction(I_MEMBER_C, name->toString());
 			} else {
 				script.addInstruction(I_BINARY, I_MEMBER);
 			}
@@ -796,6 +945,7 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 				parseOper(input, script, PREC_ALL);						// e
 			} else {
 				parseOper(input, script, PREC_ALL, I_BINARY, I_ADD);	// e
+				fold_constants(script, start);
 			}
 			if (expectToken(input, _("}\""), &token, _("}"))) {
 				parseOper(input, script, PREC_NONE);					// y
@@ -811,7 +961,8 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 			// newline functions as ;
 			// only if we don't match another token!
 			input.putBack();
-			script.addInstruction(I_POP);
+			discard_result(script, statement_start);
+			statement_start = script.getInstructions().size();
 			type = parseOper(input, script, PREC_SET);
 		} else {
 			input.putBack();
@@ -819,10 +970,12 @@ ExprType parseOper(TokenIterator& input, Script& script, Precedence minPrec, Ins
 		}
 		
 		if (type == EXPR_VAR) type = EXPR_OTHER; // var only applies to single variables, not to things with operators
+		fold_constants(script, start);
 	}
 	// add closing instruction
 	if (closeWith != I_NOP) {
 		script.addInstruction(closeWith, closeWithData);
+		fold_constants(script, start);
 	}
 	return type;
 }
@@ -8,6 +8,10 @@
 
 #include <util/prec.hpp>
 #include <script/profiler.hpp>
+#include <util/dynamic_arg.hpp> // THREAD_LOCAL
+#include <util/error.hpp>
+#include <wx/wfstream.h>
+#include <wx/txtstrm.h>
 
 #if USE_SCRIPT_PROFILING
 
@@ -17,15 +21,25 @@
 #endif
 
 DECLARE_TYPEOF(map<size_t COMMA FunctionProfileP>);
+DECLARE_TYPEOF_COLLECTION(FunctionProfileP);
+
+/// Guards the list of thread profiles, the trace, and adding children to profiles
+/** Only the thread that owns a profile tree adds children to it, so that thread can look up children without a lock.
+ *  Other threads must hold the lock while reading the children.
+ */
+wxMutex profile_mutex(wxMUTEX_RECURSIVE);
 
 // ----------------------------------------------------------------------------- : Timer
 
+/// Time excluded from the timers of this thread
+THREAD_LOCAL ProfileTime timer_delta = 0;
+
 Timer::Timer() {
-	start = timer_now() + delta;
+	start = timer_now() + timer_delta;
 }
 
 ProfileTime Timer::time() {
-	ProfileTime end = timer_now() + delta;
+	ProfileTime end = timer_now() + timer_delta;
 	ProfileTime diff = end - start;
 	start = end;
 	return diff;
@@ -33,20 +47,111 @@ ProfileTime Timer::time() {
 
 void Timer::exclude_time() {
 	ProfileTime delta_delta = time();
-	delta -= delta_delta;
+	timer_delta -= delta_delta;
 	start -= delta_delta;
 }
 
-ProfileTime Timer::delta = 0;
+// ----------------------------------------------------------------------------- : Stages
+
+const Char* profile_stage_name(ProfileStage stage) {
+	switch (stage) {
+		case PROFILE_SCRIPT: return _("script");
+		case PROFILE_LAYOUT: return _("layout");
+		case PROFILE_RENDER: return _("render");
+		case PROFILE_IMAGE:  return _("image");
+		case PROFILE_IO:     return _("io");
+		default:             return _("?");
+	}
+}
+
+void add_stage_times(const FunctionProfile& p, ProfileTime out[PROFILE_STAGE_COUNT]) {
+	// time not spent in children is spent in this function
+	ProfileTime self = p.time_ticks;
+	FOR_EACH_CONST(c, p.children) {
+		self -= c.second->time_ticks;
+		add_stage_times(*c.second, out);
+	}
+	out[p.stage] += max((ProfileTime)0, self);
+}
+void profile_stage_times(const FunctionProfile& root, ProfileTime out[PROFILE_STAGE_COUNT]) {
+	wxMutexLocker lock(profile_mutex);
+	fill(out, out + PROFILE_STAGE_COUNT, 0);
+	FOR_EACH_CONST(c, root.children) {
+		add_stage_times(*c.second, out);
+	}
+}
 
 // ----------------------------------------------------------------------------- : FunctionProfile
 
-FunctionProfile profile_root(_("root"));
+FunctionProfile profile_root(_("main thread"));
+ScriptAllocationStats script_allocations;
+
+/// Root profiles of threads other than the main thread
+vector<FunctionProfileP> thread_profiles;
+/// Indices of roots in thread_profiles whose thread has ended, these are reused by new threads
+vector<size_t> free_thread_profiles;
+
+/// The function the current thread is in, nullptr if no function has been profiled in this thread
+THREAD_LOCAL FunctionProfile* current_function = nullptr;
+/// Number of the current thread in traces, the main thread is 1
+THREAD_LOCAL int current_thread_id = 0;
+
+/// The function the current thread is in, initializes the profile of new threads
+inline FunctionProfile* current_profile() {
+	if (!current_function) {
+		if (wxThread::IsMain()) {
+			current_thread_id = 1;
+			current_function = &profile_root;
+		} else {
+			wxMutexLocker lock(profile_mutex);
+			if (free_thread_profiles.empty()) {
+				current_thread_id = (int)thread_profiles.size() + 2;
+				thread_profiles.push_back(intrusive(new FunctionProfile(String::Format(_("thread %d"), current_thread_id))));
+			} else {
+				current_thread_id = (int)free_thread_profiles.back() + 2;
+				free_thread_profiles.pop_back();
+			}
+			current_function = thread_profiles[current_thread_id - 2].get();
+		}
+	}
+	return current_function;
+}
+
+ProfiledThread::~ProfiledThread() {
+	if (current_thread_id < 2) return; // main thread, or nothing was profiled
+	wxMutexLocker lock(profile_mutex);
+	free_thread_profiles.push_back(current_thread_id - 2);
+	current_function  = nullptr;
+	current_thread_id = 0;
+}
+
+/// The child of parent with the given key, or nullptr
+/** Must be called from the thread that owns parent */
+inline FunctionProfile* find_child_profile(const FunctionProfile& parent, size_t key) {
+	map<size_t,FunctionProfileP>::const_iterator it = parent.children.find(key);
+	return it != parent.children.end() ? it->second.get() : nullptr;
+}
+/// Add a child to parent
+/** Must be called from the thread that owns parent */
+FunctionProfile* add_child_profile(FunctionProfile& parent, size_t key, const FunctionProfileP& child) {
+	wxMutexLocker lock(profile_mutex); // other threads may be reading the children
+	parent.children.insert(make_pair(key, child));
+	return child.get();
+}
+
+void profile_threads(vector<const FunctionProfile*>& out) {
+	out.push_back(&profile_root);
+	wxMutexLocker lock(profile_mutex);
+	FOR_EACH(p, thread_profiles) {
+		out.push_back(p.get());
+	}
+}
 
 inline bool compare_time(const FunctionProfileP& a, const FunctionProfileP& b) {
 	return a->time_ticks < b->time_ticks;
 }
 void FunctionProfile::get_children(vector<FunctionProfileP>& out) const {
+	wxMutexLocker lock(profile_mutex);
 	FOR_EACH_CONST(c,children) {
 		out.push_back(c.second);
 	}
@@ -81,63 +186,160 @@ void profile_aggregate(FunctionProfile& parent, int level, int max_level, const
 
 const FunctionProfile& profile_aggregated(int max_level) {
 	profile_aggr.children.clear();
-	profile_aggregate(profile_aggr, 0, max_level, profile_root);
+	vector<const FunctionProfile*> roots;
+	profile_threads(roots);
+	wxMutexLocker lock(profile_mutex);
+	FOR_EACH(r, roots) {
+		profile_aggregate(profile_aggr, 0, max_level, *r);
+	}
 	return profile_aggr;
 }
 
-// ----------------------------------------------------------------------------- : Profiler
+// ----------------------------------------------------------------------------- : Tracing
 
-FunctionProfile* Profiler::function = &profile_root;
+/// A single profiled call
+struct TraceEvent {
+	const FunctionProfile* function;
+	int                    thread;
+	ProfileTime            start, end;
+};
+
+/// Maximum number of events in a trace, further calls are not recorded
+const size_t MAX_TRACE_EVENTS = 1000000;
+
+volatile bool      tracing = false;
+ProfileTime        trace_begin;
+vector<TraceEvent> trace_events;
+size_t             trace_dropped = 0;
+
+void profile_trace_start() {
+	wxMutexLocker lock(profile_mutex);
+	trace_events.clear();
+	trace_dropped = 0;
+	trace_begin = timer_now();
+	tracing = true;
+}
+bool profile_tracing() {
+	return tracing;
+}
+
+void trace_add(const FunctionProfile* function, ProfileTime start, ProfileTime end) {
+	wxMutexLocker lock(profile_mutex);
+	if (!tracing || start < trace_begin) return; // started before the trace
+	if (trace_events.size() >= MAX_TRACE_EVENTS) {
+		++trace_dropped;
+		return;
+	}
+	TraceEvent e = { function, current_thread_id, start, end };
+	trace_events.push_back(e);
+}
+
+/// Escape a string for use in JSON
+String json_escape(const String& str) {
+	String ret; ret.reserve(str.size());
+	FOR_EACH_CONST(c, str) {
+		if (c == _('"') || c == _('\\')) {
+			ret += _('\\');
+			ret += c;
+		} else if ((unsigned)c < 0x20) {
+			ret += String::Format(_("\\u%04x"), (int)c);
+		} else {
+			ret += c;
+		}
+	}
+	return ret;
+}
+
+/// Convert a time to microseconds, the unit used by trace files
+inline double trace_time(ProfileTime t) {
+	return t * 1000000.0 / timer_resolution();
+}
+
+void profile_trace_write(const String& filename) {
+	vector<const FunctionProfile*> roots;
+	profile_threads(roots);
+	wxMutexLocker lock(profile_mutex);
+	tracing = false;
+	wxFileOutputStream file(filename);
+	if (!file.IsOk()) {
+		throw Error(_("Unable to write trace file: ") + filename);
+	}
+	wxTextOutputStream stream(file, wxEOL_UNIX);
+	writeUTF8(stream, _("{\"traceEvents\":[\n"));
+	// thread names
+	for (size_t i = 0 ; i < roots.size() ; ++i) {
+		writeUTF8(stream, String::Format(_("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}\n"),
+		                                 i == 0 ? _("") : _(","), (int)i + 1, json_escape(roots[i]->name).c_str()));
+	}
+	// calls
+	FOR_EACH_CONST(e, trace_events) {
+		writeUTF8(stream, String::Format(_(",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}\n"),
+		                                 json_escape(e.function->name).c_str(), profile_stage_name(e.function->stage),
+		                                 e.thread, trace_time(e.start - trace_begin), trace_time(e.end - e.start)));
+	}
+	writeUTF8(stream, String::Format(_("],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%d}}\n"), (int)trace_dropped));
+	trace_events.clear();
+}
+
+// ----------------------------------------------------------------------------- : Profiler
 
 // Enter a function
 Profiler::Profiler(Timer& timer, Variable function_name)
 	: timer(timer)
-	, parent(function) // push
+	, parent(current_profile()) // push
 {
 	if ((int)function_name >= 0) {
-		FunctionProfileP& fpp = parent->children[(size_t)function_name << 1 | 1];
-		if (!fpp) {
-			fpp = intrusive(new FunctionProfile(variable_to_string(function_name)));
+		size_t key = (size_t)function_name << 1 | 1;
+		FunctionProfile* fp = find_child_profile(*parent, key);
+		if (!fp) {
+			fp = add_child_profile(*parent, key, intrusive(new FunctionProfile(variable_to_string(function_name))));
 		}
-		function = fpp.get();
+		enter(fp);
+	} else {
+		enter(nullptr);
 	}
-	timer.exclude_time();
 }
 
 // Enter a function
-Profiler::Profiler(Timer& timer, const Char* function_name)
+Profiler::Profiler(Timer& timer, const Char* function_name, ProfileStage stage)
 	: timer(timer)
-	, parent(function) // push
+	, parent(current_profile()) // push
 {
-	FunctionProfileP& fpp = parent->children[(size_t)function_name];
-	if (!fpp) {
-		fpp = intrusive(new FunctionProfile(function_name));
+	FunctionProfile* fp = find_child_profile(*parent, (size_t)function_name);
+	if (!fp) {
+		fp = add_child_profile(*parent, (size_t)function_name, intrusive(new FunctionProfile(function_name, stage)));
 	}
-	function = fpp.get();
-	timer.exclude_time();
+	enter(fp);
 }
 
 // Enter a function
-Profiler::Profiler(Timer& timer, void* function_object, const String& function_name)
+Profiler::Profiler(Timer& timer, void* function_object, const String& function_name, ProfileStage stage)
 	: timer(timer)
-	, parent(function) // push
+	, parent(current_profile()) // push
 {
-	FunctionProfileP& fpp = parent->children[(size_t)function_object];
-	if (!fpp) {
-		fpp = intrusive(new FunctionProfile(function_name));
+	FunctionProfile* fp = find_child_profile(*parent, (size_t)function_object);
+	if (!fp) {
+		fp = add_child_profile(*parent, (size_t)function_object, intrusive(new FunctionProfile(function_name, stage)));
 	}
-	function = fpp.get();
+	enter(fp);
+}
+
+void Profiler::enter(FunctionProfile* function) {
+	if (function) current_function = function;
 	timer.exclude_time();
+	trace_start = tracing ? timer_now() : 0;
 }
 
 // Leave a function
 Profiler::~Profiler() {
 	ProfileTime time = timer.time();
+	FunctionProfile* function = current_function;
 	if (function == parent) return; // don't count
 	function->time_ticks += time;
 	function->time_ticks_max = max(function->time_ticks_max,time);
 	function->calls      += 1;
-	function = parent; // pop
+	if (trace_start) trace_add(function, trace_start, timer_now());
+	current_function = parent; // pop
 }
 
 // ----------------------------------------------------------------------------- : EOF
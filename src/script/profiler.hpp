@@ -41,15 +41,17 @@ DECLARE_POINTER_TYPE(FunctionProfile);
 		return t.raw_name();
 	}
 #else
-	// clock() has nanosecond resolution on Linux
-	// on any other platform, stil the best way.
-	typedef clock_t ProfileTime;
+	// a monotonic clock measures wall-clock time with nanosecond resolution,
+	// clock() only counts processor time of the whole process, and is coarse.
+	typedef long long ProfileTime;
 
 	inline ProfileTime timer_now() {
-		return clock();
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return (ProfileTime)t.tv_sec * 1000000000 + t.tv_nsec;
 	}
 	inline ProfileTime timer_resolution() {
-		return CLOCKS_PER_SEC;
+		return 1000000000;
 	}
 
 	inline const char * mangled_name(const type_info& t) {
@@ -63,23 +65,38 @@ class Timer {
 	Timer();
 	/// The time the timer has been running, resets the timer
 	inline ProfileTime time();
-	/// Exclude the time since the last reset from ALL running timers
+	/// Exclude the time since the last reset from ALL running timers in this thread
 	inline void exclude_time();
   private:
 	ProfileTime start;
-	static ProfileTime delta; ///< Time excluded
 };
 
+// ----------------------------------------------------------------------------- : Stages
+
+/// What kind of work is being profiled
+enum ProfileStage
+{	PROFILE_SCRIPT		///< Script functions
+,	PROFILE_LAYOUT		///< Laying out text
+,	PROFILE_RENDER		///< Drawing cards
+,	PROFILE_IMAGE		///< Generating images
+,	PROFILE_IO			///< Reading and writing files
+,	PROFILE_STAGE_COUNT
+};
+
+/// Name of a stage
+const Char* profile_stage_name(ProfileStage stage);
+
 // ----------------------------------------------------------------------------- : FunctionProfile
 
 /// How much time was spent in a function?
 class FunctionProfile : public IntrusivePtrBase<FunctionProfile> {
   public:
-	FunctionProfile(const String& name)
-		: name(name), time_ticks(0), time_ticks_max(0), calls(0)
+	FunctionProfile(const String& name, ProfileStage stage = PROFILE_SCRIPT)
+		: name(name), stage(stage), time_ticks(0), time_ticks_max(0), calls(0)
 	{}
 
-	String      name;
+	String       name;
+	ProfileStage stage;
 	ProfileTime time_ticks;
 	ProfileTime time_ticks_max;
 	int         calls;
@@ -97,12 +114,54 @@ class FunctionProfile : public IntrusivePtrBase<FunctionProfile> {
 	inline double max_time() const { return time_ticks_max / (double)timer_resolution(); }
 };
 
-/// The root profile
+/// The root profile of the main thread
 extern FunctionProfile profile_root;
 
-/// Return a simplified profile, where all things beyond a cerrain level are agragated
+/// The root profiles of all threads that have been profiled, starting with the main thread
+/** Each thread only ever updates its own profile, so the times in the profiles of other running threads may be inconsistent.
+ *  Their children can be read safely with get_children.
+ */
+void profile_threads(vector<const FunctionProfile*>& out);
+
+/// Declare in the entry function of a thread other than the main thread
+/** When the thread ends its profile root is reused by the next thread that is profiled,
+ *  so short lived threads don't each leave a root behind.
+ */
+class ProfiledThread {
+  public:
+	~ProfiledThread();
+};
+
+/// Time spent in each stage, not counting time spent in nested calls
+void profile_stage_times(const FunctionProfile& root, ProfileTime out[PROFILE_STAGE_COUNT]);
+
+// ----------------------------------------------------------------------------- : Allocation counters
+
+/// Number of ScriptValues allocated, by kind of allocation
+struct ScriptAllocationStats {
+	ScriptAllocationStats() : pooled(0), large(0), shared(0) {}
+	
+	AtomicInt pooled;	///< Values allocated from the ScriptValue pool
+	AtomicInt large;	///< Values too large for the pool, allocated with the global new
+	AtomicInt shared;	///< Values not allocated at all, but taken from the table of common values
+};
+
+/// Allocation counts of all ScriptValues
+extern ScriptAllocationStats script_allocations;
+
+/// Return a simplified profile of all threads, where all things beyond a cerrain level are agragated
 const FunctionProfile& profile_aggregated(int level = 1);
 
+// ----------------------------------------------------------------------------- : Tracing
+
+/// Start recording every profiled call, discards an earlier trace
+void profile_trace_start();
+/// Is a trace being recorded?
+bool profile_tracing();
+/// Stop recording, and write the trace to a file in the Chrome trace event format (JSON)
+/** The trace can be loaded in chrome://tracing and other trace viewers. */
+void profile_trace_write(const String& filename);
+
 // ----------------------------------------------------------------------------- : Profiler
 
 /// Profile a single function call
@@ -113,16 +172,19 @@ class Profiler {
 	 */
 	Profiler(Timer& timer, Variable function_name);
 	/// As above, but with a constant name
-	Profiler(Timer& timer, const Char* function_name);
+	Profiler(Timer& timer, const Char* function_name, ProfileStage stage = PROFILE_SCRIPT);
 	/// As above, but using a function object instead of a name,
 	/** if we haven't seen the object before, it gets the given name. */
-	Profiler(Timer& timer, void* function_object, const String& function_name);
+	Profiler(Timer& timer, void* function_object, const String& function_name, ProfileStage stage = PROFILE_SCRIPT);
 	/// Log the fact that the function is left
 	~Profiler();
   private:
 	Timer&                  timer;
-	static FunctionProfile* function; ///< function we are in
 	FunctionProfile*        parent;
+	ProfileTime             trace_start; ///< Start time for the trace, if tracing
+	
+	/// Enter a function, stay in the parent for function == nullptr
+	void enter(FunctionProfile* function);
 };
 
 // Profile the current function (all following code in the current block) under the given name
@@ -132,11 +194,20 @@ class Profiler {
 #define PROFILER2(name1,name2) \
 	Timer profile_timer; \
 	Profiler profiler(profile_timer, name1,name2)
+// Profile the current block as part of a stage other than scripting
+#define PROFILER_STAGE(stage,name) \
+	Timer profile_timer; \
+	Profiler profiler(profile_timer, name, stage)
+// Profile the current thread, place at the start of its entry function
+#define PROFILER_THREAD \
+	ProfiledThread profiled_thread
 
 #else // USE_SCRIPT_PROFILING
 
 #define PROFILER(a)
 #define PROFILER2(a,b)
+#define PROFILER_STAGE(a,b)
+#define PROFILER_THREAD
 
 #endif // USE_SCRIPT_PROFILING
 
@@ -16,19 +16,15 @@
 
 typedef map<String, Variable> Variables;
 Variables variables;
-DECLARE_TYPEOF(Variables);
-#ifdef _DEBUG
-	vector<String> variable_names;
-#endif
+/// Names of the variables, indexed by Variable
+vector<String> variable_names;
 
 /// Return a unique name for a variable to allow for faster loopups
 Variable string_to_variable(const String& s) {
 	Variables::iterator it = variables.find(s);
 	if (it == variables.end()) {
-		#ifdef _DEBUG
-			variable_names.push_back(s);
-			assert(s == canonical_name_form(s)); // only use cannocial names
-		#endif
+		assert(s == canonical_name_form(s)); // only use cannocial names
+		variable_names.push_back(s);
 		Variable v = (Variable)variables.size();
 		variables.insert(make_pair(s,v));
 		return v;
@@ -38,11 +34,9 @@ Variable string_to_variable(const String& s) {
 }
 
 /// Get the name of a vaiable
-/** Warning: this function is slow, it should only be used for error messages and such.
- */
 String variable_to_string(Variable v) {
-	FOR_EACH(vi, variables) {
-		if (vi.second == v) return replace_all(vi.first, _(" "), _("_"));
+	if ((size_t)v < variable_names.size()) {
+		return replace_all(variable_names[v], _(" "), _("_"));
 	}
 	throw InternalError(String(_("Variable not found: ")) << v);
 }
@@ -128,6 +122,12 @@ void Script::addInstruction(InstructionType t, const ScriptValueP& c) {
 	instructions.push_back(i);
 }
 void Script::addInstruction(InstructionType t, const String& s) {
+	if (t == I_MEMBER_C) {
+		members.push_back(MemberName(s));
+		Instruction i = {t, {(unsigned int)members.size() - 1}};
+		instructions.push_back(i);
+		return;
+	}
 	constants.push_back(to_script(s));
 	Instruction i = {t, {(unsigned int)constants.size() - 1}};
 	instructions.push_back(i);
@@ -224,9 +224,12 @@ String Script::dumpInstr(unsigned int pos, Instruction i) const {
 	}
 	// arg
 	switch (i.instr) {
-		case I_PUSH_CONST: case I_MEMBER_C:							// const
+		case I_PUSH_CONST:											// const
 			ret += _("\t") + constants[i.data]->typeName();
 			break;
+		case I_MEMBER_C:											// member name
+			ret += _("\t") + members[i.data].name;
+			break;
 		case I_JUMP: case I_JUMP_IF_NOT: case I_JUMP_SC_AND: case I_JUMP_SC_OR:
 		case I_LOOP: case I_LOOP_WITH_KEY:
 		case I_MAKE_OBJECT:
@@ -336,7 +339,7 @@ String Script::instructionName(const Instruction* instr) const {
 	} else if (instr->instr == I_MEMBER_C) {
 		return instructionName(backtraceSkip(instr - 1, 0))
 		     + _(".")
-		     + constants[instr->data]->toString();
+		     + members[instr->data].name;
 	} else if (instr->instr == I_BINARY && instr->instr2 == I_MEMBER) {
 		return _("??\?[...]");
 	} else if (instr->instr == I_BINARY && instr->instr2 == I_ADD) {
@@ -32,7 +32,7 @@ enum InstructionType
 ,	I_GET_VAR		= 4  ///< arg = var        : find a variable, push its value onto the stack, it is an error if the variable is not found
 ,	I_SET_VAR		= 5  ///< arg = var        : assign the top value from the stack to a variable (doesn't pop)
 	// Objects
-,	I_MEMBER_C		= 6  ///< arg = const name : finds a member of the top of the stack replaces the top of the stack with the member
+,	I_MEMBER_C		= 6  ///< arg = member name: finds a member of the top of the stack replaces the top of the stack with the member
 ,	I_LOOP			= 7  ///< arg = address    : loop over the elements of an iterator, which is the *second* element of the stack (this allows for combing the results of multiple iterations)
 					     ///<                    at the end performs a jump and pops the iterator. note: The second element of the stack must be an iterator!
 ,	I_LOOP_WITH_KEY	= 8  ///< arg = address    : loop, but also pushing the key
@@ -177,6 +177,7 @@ class Script : public ScriptValue {
 	/// Add an instruction with constant data
 	void addInstruction(InstructionType t, const ScriptValueP& c);
 	/// Add an instruction with string data
+	/** For I_MEMBER_C the string is stored as a member name, otherwise as a constant */
 	void addInstruction(InstructionType t, const String& s);
 	
 	/// Update an instruction to point to the current position
@@ -196,6 +197,11 @@ class Script : public ScriptValue {
 	String dumpScript() const;
 	/// Output an instruction in a human readable format
 	String dumpInstr(unsigned int pos, Instruction i) const;
+	
+	/// Hash of the contents of the files included by the source of this script, empty if there are none
+	/** The unparsed source together with this hash identifies the script */
+	inline const String& getIncludedHash() const { return included_hash; }
+	inline void setIncludedHash(const String& hash) { included_hash = hash; }
 
   protected:
 	virtual ScriptValueP do_eval(Context& ctx, bool openScope) const;
@@ -205,6 +211,10 @@ class Script : public ScriptValue {
 	vector<Instruction>  instructions;
 	/// Constant values that can be referred to from the script
 	vector<ScriptValueP> constants;
+	/// Names of members for I_MEMBER_C instructions, one per instruction, so each has its own cache
+	vector<MemberName>   members;
+	/// Hash of the included files, see getIncludedHash()
+	String               included_hash;
 	
 	/// Do a backtrace for error messages.
 	/** Starting from instr, move backwards until the nett stack effect
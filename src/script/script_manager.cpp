@@ -20,14 +20,19 @@
 #include <data/action/value.hpp>
 #include <data/action/keyword.hpp>
 #include <util/error.hpp>
+#include <util/version.hpp>
+#include <wx/wfstream.h>
 
 typedef map<const StyleSheet*,Context*> Contexts;
 DECLARE_TYPEOF(Contexts);
 DECLARE_TYPEOF_COLLECTION(CardP);
 DECLARE_TYPEOF_COLLECTION(FieldP);
 DECLARE_TYPEOF_COLLECTION(Dependency);
+DECLARE_TYPEOF_COLLECTION(DependencyCacheEntryP);
+DECLARE_TYPEOF(map<String COMMA DependencyCacheEntryP>);
 DECLARE_TYPEOF_NO_REV(IndexMap<FieldP COMMA StyleP>);
 DECLARE_TYPEOF_NO_REV(IndexMap<FieldP COMMA ValueP>);
+DECLARE_TYPEOF_COLLECTION(pair<Dependency COMMA CardP>);
 
 //#define LOG_UPDATES
 
@@ -86,6 +91,202 @@ Context& SetScriptContext::getContext(const CardP& card) {
 	return ctx;
 }
 
+// ----------------------------------------------------------------------------- : DependencyCache
+
+String user_settings_dir();
+
+DependencyRecorder* Dependencies::recorder = nullptr;
+DependencyCache dependency_cache;
+
+/// Entries that have not been used for this many days are removed from the cache
+const int DEPENDENCY_CACHE_MAX_AGE = 30;
+
+/// Seed for a second hash, so keys are two independent hashes
+const unsigned int SECOND_HASH_SEED = 0x9e3779b9u;
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(DependencyCacheEntry) {
+	REFLECT_NO_SCRIPT(key);
+	REFLECT_NO_SCRIPT(used);
+	REFLECT_NO_SCRIPT(dependencies);
+	REFLECT_NO_SCRIPT(index);
+}
+
+DependencyCache::DependencyCache()
+	: game(nullptr), stylesheet(nullptr)
+	, loaded(false), changed(false)
+{}
+
+void DependencyCache::begin(const Set& set, StyleSheet& stylesheet) {
+	this->game       = set.game.get();
+	this->stylesheet = &stylesheet;
+	Dependencies::recorder = this;
+	// the lists that dependencies can be added to,
+	// and everything that influences the analysis
+	target_names.clear();
+	targets.clear();
+	String context = app_version.toString();
+	addTarget(_("cards"),      game->dependent_scripts_cards);
+	addTarget(_("keywords"),   game->dependent_scripts_keywords);
+	addTarget(_("stylesheet"), game->dependent_scripts_stylesheet);
+	addFields(_("card"),    game->card_fields,              context);
+	addFields(_("set"),     game->set_fields,               context);
+	addFields(_("extra"),   stylesheet.extra_card_fields,   context);
+	addFields(_("styling"), stylesheet.styling_fields,      context);
+	context += _("\ngame init:")       + game->init_script.getUnparsed();
+	if (game->init_script)       context += game->init_script.getScriptP()->getIncludedHash();
+	context += _("\nstylesheet init:") + stylesheet.init_script.getUnparsed();
+	if (stylesheet.init_script) context += stylesheet.init_script.getScriptP()->getIncludedHash();
+	// the dummy card variable is nil for an empty set
+	context += set.cards.empty() ? _("\nno cards") : _("\ncards");
+	context_key = hash_string(context) + hash_string(context, SECOND_HASH_SEED);
+}
+
+void DependencyCache::end() {
+	game       = nullptr;
+	stylesheet = nullptr;
+	target_names.clear();
+	targets.clear();
+	Dependencies::recorder = nullptr;
+}
+
+void DependencyCache::addTarget(const String& name, Dependencies& target) {
+	target_names[&target] = name;
+	targets[name] = &target;
+}
+
+void DependencyCache::addFields(const String& kind, const vector<FieldP>& fields, String& context) {
+	for (size_t i = 0 ; i < fields.size() ; ++i) {
+		addTarget(kind + String::Format(_(":%d"), (int)i), fields[i]->dependent_scripts);
+		context += _("\n") + kind + _(":") + fields[i]->name;
+	}
+}
+
+void DependencyCache::dependencies(Context& ctx, const Dependency& dep, const String& unparsed, const Script& script) {
+	if (!game || unparsed.empty() || (dep.data && dep.data != stylesheet)) {
+		ctx.dependencies(dep, script);
+		return;
+	}
+	String code = unparsed + _("\n") + script.getIncludedHash()
+	            + String::Format(_("\n%d %d"), (int)dep.type, (int)dep.index) + (dep.data ? _(" s") : _(""));
+	String key = context_key + hash_string(code) + hash_string(code, SECOND_HASH_SEED);
+	// is it in the cache?
+	load();
+	map<String,DependencyCacheEntryP>::iterator it = entries.find(key);
+	if (it != entries.end() && replay(*it->second, dep)) {
+		DateTime now = DateTime::Now();
+		if (!it->second->used.IsValid() || now.Subtract(it->second->used).GetDays() >= 1) {
+			it->second->used = now;
+			changed = true;
+		}
+		return;
+	}
+	// analyse the script, and record the dependencies that are added
+	DependencyCacheEntryP entry = intrusive(new DependencyCacheEntry);
+	entry->key = key;
+	recording.push_back(entry);
+	try {
+		ctx.dependencies(dep, script);
+	} catch (...) {
+		recording.pop_back();
+		throw;
+	}
+	recording.pop_back();
+	if (entry->cacheable) {
+		entry->index = (int)dep.index;
+		entry->used  = DateTime::Now();
+		entries[key] = entry;
+		changed = true;
+	}
+}
+
+void DependencyCache::record(const Dependencies& target, const Dependency& dep) {
+	if (recording.empty()) return;
+	map<const Dependencies*,String>::const_iterator it = target_names.find(&target);
+	bool known = it != target_names.end() && (!dep.data || dep.data == stylesheet);
+	String d;
+	if (known) {
+		d = it->second + String::Format(_(" %d %d"), (int)dep.type, (int)dep.index) + (dep.data ? _(" s") : _(""));
+	}
+	FOR_EACH(e, recording) {
+		if (known) e->dependencies.push_back(d);
+		else       e->cacheable = false;
+	}
+}
+
+bool DependencyCache::replay(const DependencyCacheEntry& entry, const Dependency& dep) {
+	// decode all dependencies before adding any
+	vector<Dependencies*> to;
+	vector<Dependency>    deps;
+	FOR_EACH_CONST(d, entry.dependencies) {
+		// "target type index [s]"
+		size_t a = d.find_first_of(_(' '));
+		size_t b = d.find_first_of(_(' '), a + 1);
+		if (b == String::npos) return false;
+		size_t c = d.find_first_of(_(' '), b + 1);
+		map<String,Dependencies*>::const_iterator it = targets.find(d.substr(0, a));
+		long type, index;
+		if (it == targets.end()
+		 || !d.substr(a + 1, b - a - 1).ToLong(&type)  || type < 0 || type >= DEP_DUMMY
+		 || !d.substr(b + 1, c - b - 1).ToLong(&index) || index < 0) {
+			return false;
+		}
+		void* data = nullptr;
+		if (c != String::npos) data = stylesheet;
+		to.push_back(it->second);
+		deps.push_back(Dependency((DependencyType)type, (size_t)index, data));
+	}
+	for (size_t i = 0 ; i < to.size() ; ++i) {
+		to[i]->add(deps[i]);
+	}
+	if (dep.type == DEP_DUMMY) {
+		// the analysis may have marked the dummy dependency, see Style::markDependencyMember
+		const_cast<Dependency&>(dep).index = entry.index;
+	}
+	return true;
+}
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(DependencyCache) {
+	REFLECT_NO_SCRIPT_N("entries", entry_list);
+}
+
+void DependencyCache::load() {
+	if (loaded) return;
+	loaded = true;
+	String filename = cacheFile();
+	if (!wxFileExists(filename)) return;
+	wxFileInputStream file(filename);
+	if (!file.Ok()) return; // failure is not an error, the cache is rebuilt
+	try {
+		Reader reader(file, nullptr, filename);
+		reader.handle_greedy(*this);
+		FOR_EACH(e, entry_list) {
+			entries[e->key] = e;
+		}
+	} catch (const Error&) {}
+	entry_list.clear();
+}
+
+void DependencyCache::save() {
+	if (!changed) return;
+	changed = false;
+	wxFileOutputStream stream(cacheFile());
+	if (!stream.IsOk()) return;
+	// forget about entries that are no longer used
+	DateTime now = DateTime::Now();
+	FOR_EACH(e, entries) {
+		if (e.second->used.IsValid() && now.Subtract(e.second->used).GetDays() < DEPENDENCY_CACHE_MAX_AGE) {
+			entry_list.push_back(e.second);
+		}
+	}
+	Writer writer(stream, app_version);
+	writer.handle(*this);
+	entry_list.clear();
+}
+
+String DependencyCache::cacheFile() const {
+	return user_settings_dir() + _("/dependency-cache");
+}
+
 // ----------------------------------------------------------------------------- : SetScriptManager : initialization
 
 SetScriptManager::SetScriptManager(Set& set)
@@ -103,6 +304,7 @@ SetScriptManager::~SetScriptManager() {
 void SetScriptManager::onInit(const StyleSheetP& stylesheet, Context* ctx) {
 	assert(wxThread::IsMain());
 	// initialize dependencies
+	dependency_cache.begin(set, *stylesheet);
 	try {
 		// find script dependencies
 		initDependencies(*ctx, *set.game);
@@ -110,6 +312,7 @@ void SetScriptManager::onInit(const StyleSheetP& stylesheet, Context* ctx) {
 	} catch (const Error& e) {
 		handle_error(e);
 	}
+	dependency_cache.end();
 }
 
 void SetScriptManager::initDependencies(Context& ctx, Game& game) {
@@ -151,7 +354,20 @@ void SetScriptManager::initDependencies(Context& ctx, StyleSheet& stylesheet) {
 
 // ----------------------------------------------------------------------------- : ScriptManager : updating
 
+bool SetScriptManager::listensTo(const Action& action) const {
+	return is_action<ValueAction>(action)
+	    || is_action<MultipleValueAction>(action)
+	    || is_action<CardListAction>(action)
+	    || is_action<KeywordListAction>(action)
+	    || is_action<ChangeKeywordModeAction>(action)
+	    || is_action<DisplayChangeAction>(action);
+}
+
 void SetScriptManager::onAction(const Action& action, bool undone) {
+	TYPE_CASE(action, MultipleValueAction) {
+		updateValues(action);
+		return;
+	}
 	TYPE_CASE(action, ValueAction) {
 		if (action.card) {
 			// we can just turn the Card* into a CardP
@@ -180,6 +396,7 @@ void SetScriptManager::onAction(const Action& action, bool undone) {
 		return; // Don't go into an infinite loop because of our own events
 	}
 	TYPE_CASE(action, AddCardAction) {
+		set.clearOrderCache(); // the card list has changed
 		if (action.action.adding != undone) {
 			// update the added cards specificly
 			FOR_EACH_CONST(step, action.action.steps) {
@@ -193,6 +410,7 @@ void SetScriptManager::onAction(const Action& action, bool undone) {
 		// note: fallthrough
 	}
 	TYPE_CASE_(action, CardListAction) {
+		set.clearOrderCache(); // the card list has changed
 		#ifdef LOG_UPDATES
 			wxLogDebug(_("Card dependencies"));
 		#endif
@@ -276,11 +494,85 @@ void SetScriptManager::updateValue(Value& value, const CardP& card, Action const
 	#endif
 }
 
+/// Order on dependencies for a card, to find the distinct ones
+struct CardDependencyLess {
+	bool operator () (const pair<Dependency,CardP>& a, const pair<Dependency,CardP>& b) const {
+		if (a.first.type  != b.first.type)  return a.first.type  < b.first.type;
+		if (a.first.index != b.first.index) return a.first.index < b.first.index;
+		if (a.first.data  != b.first.data)  return a.first.data  < b.first.data;
+		return a.second < b.second;
+	}
+};
+
+/// The distinct dependencies of a number of values, each with the card it applies to
+class DistinctDependencies {
+  public:
+	DistinctDependencies(const Game& game) : game(game) {}
+	
+	vector<pair<Dependency,CardP> > deps; ///< In the order in which they were first added
+	
+	/// Add the dependencies of a value of the given card (or no card)
+	void add(const vector<Dependency>& dependent_scripts, const CardP& card) {
+		FOR_EACH_CONST(d, dependent_scripts) {
+			switch (d.type) {
+				case DEP_CARD_FIELD:
+					if (card) addDistinct(d, card);
+					else      addDistinct(d.makeCardIndependend(), CardP());
+					break;
+				case DEP_ORDER_CACHE:
+					addDistinct(d, card);
+					break;
+				case DEP_CARD_COPY_DEP:
+					add(game.card_fields[d.index]->dependent_scripts, card);
+					break;
+				case DEP_SET_COPY_DEP:
+					add(game.set_fields[d.index]->dependent_scripts, card);
+					break;
+				default:
+					// the same for all cards
+					addDistinct(d, CardP());
+			}
+		}
+	}
+	
+  private:
+	const Game& game;
+	set<pair<Dependency,CardP>, CardDependencyLess> seen;
+	
+	void addDistinct(const Dependency& dep, const CardP& card) {
+		pair<Dependency,CardP> d(dep, card);
+		if (seen.insert(d).second) deps.push_back(d);
+	}
+};
+
+void SetScriptManager::updateValues(const MultipleValueAction& action) {
+	Age starting_age = Age::next();
+	deque<ToUpdate> to_update;
+	// execute scripts for all changed values first, then do a single pass over the things depending on them
+	// things depending on more than one of the values, or on all cards, are only expanded once
+	DistinctDependencies deps(*set.game);
+	FOR_EACH_CONST(a, action.actions) {
+		CardP card = a->card ? intrusive_from_existing(const_cast<Card*>(a->card)) : CardP();
+		Value& value = *a->valueP;
+		value.last_modified = starting_age;
+		value.update(getContext(card), a);
+		deps.add(value.fieldP->dependent_scripts, card);
+	}
+	FOR_EACH(d, deps.deps) {
+		alsoUpdate(to_update, d.first, d.second);
+	}
+	updateRecursive(to_update, starting_age);
+	#ifdef LOG_UPDATES
+		wxLogDebug(_("-------------------------------\n"));
+	#endif
+}
+
 void SetScriptManager::updateAll() {
 	#ifdef LOG_UPDATES
 		wxLogDebug(_("Update all"));
 	#endif
 	wxBusyCursor busy;
+	set.clearOrderCache(); // everything is going to be re-evaluated
 	// update set data
 	Context& ctx = getContext(set.stylesheet);
 	FOR_EACH(v, set.data) {
@@ -322,7 +614,6 @@ void SetScriptManager::updateAllDependend(const vector<Dependency>& dependent_sc
 
 void SetScriptManager::updateRecursive(deque<ToUpdate>& to_update, Age starting_age) {
 	if (to_update.empty()) return;
-	set.clearOrderCache(); // clear caches before evaluating a round of scripts
 	while (!to_update.empty()) {
 		updateToUpdate(to_update.front(), to_update, starting_age);
 		to_update.pop_front();
@@ -358,59 +649,71 @@ void SetScriptManager::updateToUpdate(const ToUpdate& u, deque<ToUpdate>& to_upd
 
 void SetScriptManager::alsoUpdate(deque<ToUpdate>& to_update, const vector<Dependency>& deps, const CardP& card) {
 	FOR_EACH_CONST(d, deps) {
-		switch (d.type) {
-			case DEP_SET_FIELD: {
-				ValueP value = set.data.at(d.index);
-				to_update.push_back(ToUpdate(value.get(), CardP()));
+		alsoUpdate(to_update, d, card);
+	}
+}
+
+void SetScriptManager::alsoUpdate(deque<ToUpdate>& to_update, const Dependency& d, const CardP& card) {
+	switch (d.type) {
+		case DEP_SET_FIELD: {
+			ValueP value = set.data.at(d.index);
+			to_update.push_back(ToUpdate(value.get(), CardP()));
+			break;
+		} case DEP_CARD_FIELD: {
+			if (card) {
+				ValueP value = card->data.at(d.index);
+				to_update.push_back(ToUpdate(value.get(), card));
 				break;
-			} case DEP_CARD_FIELD: {
-				if (card) {
-					ValueP value = card->data.at(d.index);
-					to_update.push_back(ToUpdate(value.get(), card));
-					break;
-				} else {
-					// There is no card, so the update should affect all cards (fall through).
-				}
-			} case DEP_CARDS_FIELD: {
-				// something invalidates a card value for all cards, so all cards need updating
-				FOR_EACH(card, set.cards) {
-					ValueP value = card->data.at(d.index);
+			} else {
+				// There is no card, so the update should affect all cards (fall through).
+			}
+		} case DEP_CARDS_FIELD: {
+			// something invalidates a card value for all cards, so all cards need updating
+			FOR_EACH(card, set.cards) {
+				ValueP value = card->data.at(d.index);
+				to_update.push_back(ToUpdate(value.get(), card));
+			}
+			break;
+		} case DEP_CARD_STYLE: {
+			// a generated image has become invalid, there is not much we can do
+			// because the index is not exact enough, it only gives the field
+			StyleSheet* stylesheet = reinterpret_cast<StyleSheet*>(d.data);
+			StyleP style = stylesheet->card_style.at(d.index);
+			style->invalidate();
+			// something changed, send event
+			ScriptStyleEvent change(stylesheet, style.get());
+			set.actions.tellListeners(change, false);
+			break;
+		} case DEP_EXTRA_CARD_FIELD: {
+		/*	// Not needed, extra card fields are handled in updateStyles()
+			if (card) {
+				StyleSheet* stylesheet = reinterpret_cast<StyleSheet*>(d.data);
+				StyleSheet* stylesheet_card = &set.stylesheetFor(card);
+				if (stylesheet == stylesheet_card) {
+					ValueP value = card->extra_data.at(d.index);
 					to_update.push_back(ToUpdate(value.get(), card));
 				}
-				break;
-			} case DEP_CARD_STYLE: {
-				// a generated image has become invalid, there is not much we can do
-				// because the index is not exact enough, it only gives the field
-				StyleSheet* stylesheet = reinterpret_cast<StyleSheet*>(d.data);
-				StyleP style = stylesheet->card_style.at(d.index);
-				style->invalidate();
-				// something changed, send event
-				ScriptStyleEvent change(stylesheet, style.get());
-				set.actions.tellListeners(change, false);
-				break;
-			} case DEP_EXTRA_CARD_FIELD: {
-			/*	// Not needed, extra card fields are handled in updateStyles()
-				if (card) {
-					StyleSheet* stylesheet = reinterpret_cast<StyleSheet*>(d.data);
-					StyleSheet* stylesheet_card = &set.stylesheetFor(card);
-					if (stylesheet == stylesheet_card) {
-						ValueP value = card->extra_data.at(d.index);
-						to_update.push_back(ToUpdate(value.get(), card));
-					}
-				}*/
-				break;
-			} case DEP_CARD_COPY_DEP: {
-				// propagate dependencies from another field
-				FieldP f = set.game->card_fields[d.index];
-				alsoUpdate(to_update, f->dependent_scripts, card);
-				break;
-			} case DEP_SET_COPY_DEP: {
-				// propagate dependencies from another field
-				FieldP f = set.game->set_fields[d.index];
-				alsoUpdate(to_update, f->dependent_scripts, card);
-				break;
-			} default:
-				assert(false);
-		}
+			}*/
+			break;
+		} case DEP_CARD_COPY_DEP: {
+			// propagate dependencies from another field
+			FieldP f = set.game->card_fields[d.index];
+			alsoUpdate(to_update, f->dependent_scripts, card);
+			break;
+		} case DEP_SET_COPY_DEP: {
+			// propagate dependencies from another field
+			FieldP f = set.game->set_fields[d.index];
+			alsoUpdate(to_update, f->dependent_scripts, card);
+			break;
+		} case DEP_ORDER_CACHE: {
+			// the sort key or filter of a card has changed, move just that card in the order cache
+			if (card) {
+				set.updateOrderCache(card);
+			} else {
+				set.clearOrderCache();
+			}
+			break;
+		} default:
+			assert(false);
 	}
 }
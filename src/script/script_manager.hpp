@@ -10,6 +10,7 @@
 // ----------------------------------------------------------------------------- : Includes
 
 #include <util/prec.hpp>
+#include <util/reflect.hpp>
 #include <util/action_stack.hpp>
 #include <util/age.hpp>
 #include <script/context.hpp>
@@ -18,11 +19,13 @@
 
 class Set;
 class Value;
+class MultipleValueAction;
 DECLARE_POINTER_TYPE(Game);
 DECLARE_POINTER_TYPE(StyleSheet);
 DECLARE_POINTER_TYPE(Card);
 DECLARE_POINTER_TYPE(Field);
 DECLARE_POINTER_TYPE(Style);
+DECLARE_POINTER_TYPE(DependencyCacheEntry);
 
 // ----------------------------------------------------------------------------- : SetScriptContext
 
@@ -46,6 +49,74 @@ class SetScriptContext {
 };
 
 
+// ----------------------------------------------------------------------------- : DependencyCache
+
+/// The result of analysing a script with one dependency, see DependencyCache
+class DependencyCacheEntry : public IntrusivePtrBase<DependencyCacheEntry> {
+  public:
+	DependencyCacheEntry() : index(0), cacheable(true) {}
+	
+	String         key;
+	DateTime       used;			///< When was this entry last used? Entries that are not used for a while are removed
+	vector<String> dependencies;	///< The dependencies that were added, as "target type index [s]"
+	int            index;			///< For a DEP_DUMMY dependency: its index after the analysis
+	bool           cacheable;		///< Were all dependencies added to lists that the cache knows about?
+	
+	DECLARE_REFLECTION();
+};
+
+/// A persistent cache of the results of dependency analysis
+/** Analysing a script adds the dependency to the dependent_scripts lists of the things the script uses.
+ *  These additions are recorded, and replayed when the same script is analysed again,
+ *  also in later runs of the program.
+ *
+ *  Entries are keyed by a hash of the source of the script (including included files), the dependency,
+ *  and everything in the context that influences the analysis:
+ *  the init scripts and the fields of the game and stylesheet.
+ *  So after changing a script, only that script is analysed again.
+ */
+class DependencyCache : public DependencyRecorder {
+  public:
+	DependencyCache();
+	
+	/// Start analysing the scripts of the game of a set and a stylesheet
+	void begin(const Set& set, StyleSheet& stylesheet);
+	/// Done analysing
+	void end();
+	
+	/// Find the dependencies of a script, by replaying them from the cache or by analysing the script
+	/** unparsed is the source of the script, if it is empty the script is always analysed */
+	void dependencies(Context& ctx, const Dependency& dep, const String& unparsed, const Script& script);
+	
+	/// Write the cache to disk, if it has changed
+	void save();
+	
+	virtual void record(const Dependencies& target, const Dependency& dep);
+	
+  private:
+	Game*       game;			///< Game that is being analysed, nullptr outside begin()/end()
+	StyleSheet* stylesheet;		///< Stylesheet that is being analysed
+	String      context_key;	///< Hash of the game and stylesheet, part of all keys
+	map<const Dependencies*,String> target_names;	///< Names of the lists that dependencies can be added to
+	map<String,Dependencies*>       targets;		///< The lists by name
+	vector<DependencyCacheEntryP>   recording;		///< Entries of the analyses in progress
+	
+	bool loaded, changed;
+	map<String,DependencyCacheEntryP> entries;		///< Results by key
+	vector<DependencyCacheEntryP>     entry_list;	///< The entries as stored in the cache file
+	
+	void addTarget(const String& name, Dependencies& target);
+	void addFields(const String& kind, const vector<FieldP>& fields, String& context);
+	/// Add the dependencies of a cached entry, returns false if they can not be used
+	bool replay(const DependencyCacheEntry& entry, const Dependency& dep);
+	void load();
+	String cacheFile() const;
+	DECLARE_REFLECTION();
+};
+
+/// The global dependency cache
+extern DependencyCache dependency_cache;
+
 // ----------------------------------------------------------------------------- : SetScriptManager
 
 /// Manager of the script context for a set, keeps scripts up to date
@@ -85,6 +156,8 @@ class SetScriptManager : public SetScriptContext, public ActionListener {
 	 *  optionally: action that causes this update
 	 */
 	void updateValue(Value& value, const CardP& card, const Action* action);
+	/// Updates scripts for all values changed by an action, and then everything that depends on them
+	void updateValues(const MultipleValueAction& action);
 	// Update all values with a specific dependency
 	void updateAllDependend(const vector<Dependency>& dependent_scripts, const CardP& card = CardP());
 	
@@ -101,6 +174,8 @@ class SetScriptManager : public SetScriptContext, public ActionListener {
 	void updateToUpdate(const ToUpdate& u, deque<ToUpdate>& to_update, Age starting_age);
 	/// Schedule all things in deps to be updated by adding them to to_update
 	void alsoUpdate(deque<ToUpdate>& to_update, const vector<Dependency>& deps, const CardP& card);
+	/// Schedule the thing depending on a single dependency to be updated
+	void alsoUpdate(deque<ToUpdate>& to_update, const Dependency& dep, const CardP& card);
 	
 	/// Delayed update for (bitmask)...
 	enum Delay
@@ -112,6 +187,8 @@ class SetScriptManager : public SetScriptContext, public ActionListener {
   protected:
 	/// Respond to actions by updating scripts
 	void onAction(const Action&, bool undone);
+	/// Only actions that change data, in particular not our own ScriptValueEvents
+	virtual bool listensTo(const Action&) const;
 };
 
 // ----------------------------------------------------------------------------- : EOF
@@ -12,6 +12,7 @@
 #include <script/parser.hpp>
 #include <script/script.hpp>
 #include <script/value.hpp>
+#include <script/script_manager.hpp>
 #include <gfx/color.hpp>
 
 Alignment from_string(const String&);
@@ -79,7 +80,7 @@ void OptionalScript::parse(Reader& reader, bool string_mode) {
 
 void OptionalScript::initDependencies(Context& ctx, const Dependency& dep) const {
 	if (script) {
-		ctx.dependencies(dep, *script);
+		dependency_cache.dependencies(ctx, dep, unparsed, *script);
 	}
 }
 
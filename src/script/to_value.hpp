@@ -253,6 +253,19 @@ ScriptValueP get_member(const IndexMap<K,V>& m, const String& name) {
 		return delay_error(ScriptErrorNoMember(_TYPE_("collection"), name));
 	}
 }
+template <typename K, typename V>
+ScriptValueP get_member(const IndexMap<K,V>& m, const MemberName& name) {
+	typename IndexMap<K,V>::const_iterator it = m.find(name.name, name.hint);
+	if (it != m.end()) {
+		return to_script(*it);
+	} else {
+		return delay_error(ScriptErrorNoMember(_TYPE_("collection"), name.name));
+	}
+}
+template <typename Collection>
+ScriptValueP get_member(const Collection& c, const MemberName& name) {
+	return get_member(c, name.name);
+}
 
 /// Script value containing a map-like collection
 template <typename Collection>
@@ -264,6 +277,9 @@ class ScriptMap : public ScriptValue {
 	virtual ScriptValueP getMember(const String& name) const {
 		return get_member(*value, name);
 	}
+	virtual ScriptValueP getMember(const MemberName& name) const {
+		return get_member(*value, name);
+	}
 	virtual int itemCount() const { return (int)value->size(); }
 	virtual ScriptValueP dependencyMember(const String& name, const Dependency& dep) const {
 		mark_dependency_member(*value, name, dep);
@@ -342,11 +358,17 @@ class ScriptObject : public ScriptValue {
 		ScriptValueP d = getDefault(); return d ? d->toImage() : ScriptValue::toImage();
 	}
 	virtual ScriptValueP getMember(const String& name) const {
+		return getMember(name, nullptr);
+	}
+	virtual ScriptValueP getMember(const MemberName& name) const {
+		return getMember(name.name, &name.hint);
+	}
+	ScriptValueP getMember(const String& name, size_t* hint) const {
 		#if USE_SCRIPT_PROFILING
 			Timer t;
 			Profiler prof(t, (void*)mangled_name(typeid(T)), _("get member of ") + type_name(*value));
 		#endif
-		GetMember gm(name);
+		GetMember gm(name, hint);
 		gm.handle(*value);
 		if (gm.result()) return gm.result();
 		else {
@@ -13,10 +13,101 @@
 #include <gfx/generated_image.hpp>
 #include <util/error.hpp>
 #include <util/tagged_string.hpp>
-#include <boost/pool/singleton_pool.hpp>
+#include <script/profiler.hpp>
+#include <wx/thread.h>
 
 DECLARE_TYPEOF_COLLECTION(pair<Variable COMMA ScriptValueP>);
 
+// ----------------------------------------------------------------------------- : Allocation
+
+/// Allocator for small ScriptValues
+/** Memory is handed out in blocks from larger slabs, with a free list for each size class.
+ *  To reduce contention between threads, each size class is split into shards, chosen by thread id.
+ *  Freed blocks go to the shard of the thread that frees them.
+ *
+ *  Slabs are never released, and the allocator itself is never destroyed,
+ *  because global ScriptValues can be destroyed after any other global object.
+ */
+class ScriptValueAllocator {
+  public:
+	static const size_t GRANULARITY  = 16;
+	static const size_t SIZE_CLASSES = 8;	///< Sizes up to 128 bytes are pooled
+	static const size_t SHARDS       = 4;
+	static const size_t SLAB_SIZE    = 16384;
+	
+	ScriptValueAllocator() {
+		memset(free_lists, 0, sizeof(free_lists));
+	}
+	
+	inline void* alloc(size_t size) {
+		if (size > GRANULARITY * SIZE_CLASSES) {
+			#if USE_SCRIPT_PROFILING
+				++script_allocations.large;
+			#endif
+			return ::operator new(size);
+		}
+		#if USE_SCRIPT_PROFILING
+			++script_allocations.pooled;
+		#endif
+		size_t cls = (size - 1) / GRANULARITY;
+		size_t shard = current_shard();
+		wxCriticalSectionLocker lock(locks[cls][shard]);
+		FreeBlock*& list = free_lists[cls][shard];
+		if (!list) list = newSlab(cls);
+		FreeBlock* block = list;
+		list = block->next;
+		return block;
+	}
+	inline void free(void* p, size_t size) {
+		if (size > GRANULARITY * SIZE_CLASSES) {
+			::operator delete(p);
+			return;
+		}
+		size_t cls = (size - 1) / GRANULARITY;
+		size_t shard = current_shard();
+		wxCriticalSectionLocker lock(locks[cls][shard]);
+		FreeBlock* block = static_cast<FreeBlock*>(p);
+		block->next = free_lists[cls][shard];
+		free_lists[cls][shard] = block;
+	}
+	
+  private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	wxCriticalSection locks[SIZE_CLASSES][SHARDS];
+	FreeBlock*        free_lists[SIZE_CLASSES][SHARDS];
+	
+	static inline size_t current_shard() {
+		size_t id = (size_t)wxThread::GetCurrentId();
+		return (id ^ (id >> 8) ^ (id >> 16)) % SHARDS;
+	}
+	/// Allocate a new slab, and make a free list out of it
+	static FreeBlock* newSlab(size_t cls) {
+		size_t block_size = (cls + 1) * GRANULARITY;
+		size_t count = SLAB_SIZE / block_size;
+		char* slab = static_cast<char*>(::operator new(count * block_size));
+		for (size_t i = 0 ; i + 1 < count ; ++i) {
+			reinterpret_cast<FreeBlock*>(slab + i * block_size)->next = reinterpret_cast<FreeBlock*>(slab + (i + 1) * block_size);
+		}
+		reinterpret_cast<FreeBlock*>(slab + (count - 1) * block_size)->next = nullptr;
+		return reinterpret_cast<FreeBlock*>(slab);
+	}
+};
+
+/// The allocator, initialized on first use, which happens during static initialization
+inline ScriptValueAllocator& script_value_allocator() {
+	static ScriptValueAllocator* allocator = new ScriptValueAllocator;
+	return *allocator;
+}
+
+void* ScriptValue::operator new(size_t size) {
+	return script_value_allocator().alloc(size);
+}
+void ScriptValue::operator delete(void* p, size_t size) {
+	if (p) script_value_allocator().free(p, size);
+}
+
 // ----------------------------------------------------------------------------- : ScriptValue
 // Base cases
 
@@ -45,6 +136,9 @@ ScriptValueP ScriptValue::getMember(const String& name) const {
 		return delay_error(ScriptErrorNoMember(typeName(), name));
 	}
 }
+ScriptValueP ScriptValue::getMember(const MemberName& name) const {
+	return getMember(name.name);
+}
 ScriptValueP ScriptValue::getIndex(int index) const {
 	return delay_error(ScriptErrorNoMember(typeName(), String()<<index));
 }
@@ -151,8 +245,6 @@ ScriptValueP rangeIterator(int start, int end) {
 
 // ----------------------------------------------------------------------------- : Integers
 
-#define USE_POOL_ALLOCATOR
-
 // Integer values
 class ScriptInt : public ScriptValue {
   public:
@@ -162,24 +254,35 @@ class ScriptInt : public ScriptValue {
 	virtual String toString() const { return String() << value; }
 	virtual double toDouble() const { return value; }
 	virtual int    toInt()    const { return value; }
-  protected:
-#ifdef USE_POOL_ALLOCATOR
-	virtual void destroy() {
-		boost::singleton_pool<ScriptValue, sizeof(ScriptInt)>::free(this);
-	}
-#endif
   private:
 	int value;
 };
 
+/// Range of integers that are preallocated
+const int SMALL_INT_MIN = -128;
+const int SMALL_INT_MAX = 1023;
+
+/// Table of preallocated integers, these are shared instead of allocating a new value each time
+/** The table is never destroyed, it may be used during the destruction of other globals.
+ *  It is nullptr until it is initialized, during static initialization.
+ */
+ScriptValueP* make_small_ints() {
+	ScriptValueP* table = new ScriptValueP[SMALL_INT_MAX - SMALL_INT_MIN + 1];
+	for (int i = SMALL_INT_MIN ; i <= SMALL_INT_MAX ; ++i) {
+		table[i - SMALL_INT_MIN] = intrusive(new ScriptInt(i));
+	}
+	return table;
+}
+ScriptValueP* small_ints = make_small_ints();
+
 ScriptValueP to_script(int v) {
-#ifdef USE_POOL_ALLOCATOR
-	return intrusive(
-			new(boost::singleton_pool<ScriptValue, sizeof(ScriptInt)>::malloc())
-				ScriptInt(v));
-#else
+	if (v >= SMALL_INT_MIN && v <= SMALL_INT_MAX && small_ints) {
+		#if USE_SCRIPT_PROFILING
+			++script_allocations.shared;
+		#endif
+		return small_ints[v - SMALL_INT_MIN];
+	}
 	return intrusive(new ScriptInt(v));
-#endif
 }
 
 // ----------------------------------------------------------------------------- : Booleans
@@ -317,7 +420,27 @@ class ScriptString : public ScriptValue {
 	String value;
 };
 
+/// Table of preallocated strings of at most one ASCII character, indexed by that character (empty string at 0)
+ScriptValueP* make_short_strings() {
+	ScriptValueP* table = new ScriptValueP[128];
+	table[0] = intrusive(new ScriptString(String()));
+	for (int c = 1 ; c < 128 ; ++c) {
+		table[c] = intrusive(new ScriptString(String(1,(Char)c)));
+	}
+	return table;
+}
+ScriptValueP* short_strings = make_short_strings();
+
 ScriptValueP to_script(const String& v) {
+	if (v.size() <= 1 && short_strings) {
+		unsigned int c = v.empty() ? 0 : (unsigned int)v.GetChar(0);
+		if (c < 128 && (c != 0 || v.empty())) {
+			#if USE_SCRIPT_PROFILING
+				++script_allocations.shared;
+			#endif
+			return short_strings[c];
+		}
+	}
 	return intrusive(new ScriptString(v));
 }
 
@@ -527,9 +650,13 @@ ScriptValueP ScriptClosure::simplify() {
 }
 
 ScriptValueP ScriptClosure::do_eval(Context& ctx, bool openScope) const {
-	scoped_ptr<LocalScope> scope(openScope ? new LocalScope(ctx) : nullptr);
+	if (!openScope) {
+		applyBindings(ctx);
+		return fun->eval(ctx, false);
+	}
+	LocalScope scope(ctx);
 	applyBindings(ctx);
-	return fun->eval(ctx, openScope);
+	return fun->eval(ctx, true);
 }
 ScriptValueP ScriptClosure::dependencies(Context& ctx, const Dependency& dep) const {
 	LocalScope scope(ctx);
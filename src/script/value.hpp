@@ -45,11 +45,25 @@ enum CompareWhat
 ,	COMPARE_AS_POINTER
 };
 
+/// The name of a member that is looked up by a script, with a cache of where it was found last time
+/** The hint is only a guess, it is always verified, so it can be shared between threads.
+ */
+struct MemberName {
+	inline MemberName(const String& name) : name(name), hint(0) {}
+	
+	String         name;
+	mutable size_t hint;	///< Position in an IndexMap where the member was last found
+};
+
 /// A value that can be handled by the scripting engine.
 /// Actual values are derived types
 class ScriptValue : public IntrusivePtrBaseWithDelete {
   public:
 	virtual ~ScriptValue() {}
+	
+	/// ScriptValues are allocated from a pool, because scripts create many small short lived values
+	static void* operator new(size_t size);
+	static void  operator delete(void* p, size_t size);
 
 	/// Information on the type of this value
 	virtual ScriptType type() const = 0;
@@ -82,6 +96,9 @@ class ScriptValue : public IntrusivePtrBaseWithDelete {
 	
 	/// Get a member variable from this value
 	virtual ScriptValueP getMember(const String& name) const;
+	/// Get a member variable from this value, using (and updating) the cached position
+	/** By default the cache is not used */
+	virtual ScriptValueP getMember(const MemberName& name) const;
 
 	/// Signal that a script depends on this value itself
 	virtual void dependencyThis(const Dependency& dep);
@@ -18,7 +18,12 @@ DECLARE_TYPEOF_COLLECTION(ActionListener*);
 
 ActionStack::ActionStack()
 	: save_point(nullptr)
+	, save_point_lost(false)
 	, last_was_add(false)
+	, listener_table_valid(true)
+	, telling_listeners(0)
+	, memory_used(0)
+	, memory_limit(0)
 {}
 
 ActionStack::~ActionStack() {
@@ -33,26 +38,46 @@ void ActionStack::addAction(Action* action, bool allow_merge) {
 	tellListeners(*action, false);
 	// clear redo list
 	if (!redo_actions.empty()) allow_merge = false; // don't merge after undo
-	FOR_EACH(a, redo_actions) delete a;
+	FOR_EACH(a, redo_actions) {
+		if (a == save_point) save_point_lost = true;
+		memory_used -= a->memoryUsage();
+		delete a;
+	}
 	redo_actions.clear();
 	// try to merge?
+	bool merged = false;
 	if (allow_merge && !undo_actions.empty() &&
 	    last_was_add                         && // never merge with something that was redone once already
-	    undo_actions.back() != save_point    && // never merge with the save point
-	    undo_actions.back()->merge(*action) // merged with top undo action
+	    undo_actions.back() != save_point       // never merge with the save point
 	    ) {
+		Action* top = undo_actions.back();
+		size_t top_memory = top->memoryUsage();
+		merged = top->merge(*action); // merge with top undo action
+		memory_used -= top_memory;
+		memory_used += top->memoryUsage();
+	}
+	if (merged) {
 		delete action;
 	} else {
+		if (!undo_actions.empty()) {
+			// the current top action is covered, nothing will be merged into it anymore
+			Action* top = undo_actions.back();
+			memory_used -= top->memoryUsage();
+			top->compact();
+			memory_used += top->memoryUsage();
+		}
 		undo_actions.push_back(action);
+		memory_used += action->memoryUsage();
 	}
 	last_was_add = true;
+	limitMemory();
 }
 
 void ActionStack::undo() {
 	assert(canUndo());
 	if (!canUndo()) return;
 	Action* action = undo_actions.back();
-	action->perform(true);
+	perform(action, true);
 	tellListeners(*action, true);
 	// move to redo stack
 	undo_actions.pop_back();
@@ -63,7 +88,7 @@ void ActionStack::redo() {
 	assert(canRedo());
 	if (!canRedo()) return;
 	Action* action = redo_actions.back();
-	action->perform(false);
+	perform(action, false);
 	tellListeners(*action, false);
 	// move to undo stack
 	redo_actions.pop_back();
@@ -94,8 +119,9 @@ String ActionStack::redoName() const {
 }
 
 bool ActionStack::atSavePoint() const {
+	if (save_point_lost) return false;
 	return (undo_actions.empty() && save_point == nullptr)
-	    || (undo_actions.back() == save_point);
+	    || (!undo_actions.empty() && undo_actions.back() == save_point);
 }
 void ActionStack::setSavePoint() {
 	if (undo_actions.empty()) {
@@ -103,10 +129,45 @@ void ActionStack::setSavePoint() {
 	} else {
 		save_point = undo_actions.back();
 	}
+	save_point_lost = false;
+}
+
+// ----------------------------------------------------------------------------- : Memory limit
+
+void ActionStack::setMemoryLimit(size_t limit) {
+	memory_limit = limit;
+	limitMemory();
+}
+
+void ActionStack::perform(Action* action, bool to_undo) {
+	memory_used -= action->memoryUsage();
+	action->perform(to_undo);
+	memory_used += action->memoryUsage();
+}
+
+void ActionStack::limitMemory() {
+	if (memory_limit == 0) return;
+	// forget the oldest undo actions, but always keep the last one
+	size_t forget = 0;
+	while (memory_used > memory_limit && forget + 1 < undo_actions.size()) {
+		Action* a = undo_actions[forget++];
+		// save_point == nullptr means the state before the first action on the stack
+		if (save_point == nullptr) {
+			save_point_lost = true; // which can no longer be reached
+		} else if (save_point == a) {
+			save_point = nullptr; // the state after a is now the bottom of the stack
+		}
+		memory_used -= a->memoryUsage();
+		delete a;
+	}
+	undo_actions.erase(undo_actions.begin(), undo_actions.begin() + forget);
 }
 
+// ----------------------------------------------------------------------------- : Listeners
+
 void ActionStack::addListener(ActionListener* listener) {
 	listeners.push_back(listener);
+	listener_table_valid = false;
 }
 void ActionStack::removeListener(ActionListener* listener) {
 	listeners.erase(
@@ -117,7 +178,51 @@ void ActionStack::removeListener(ActionListener* listener) {
 			),
 		listeners.end()
 		);
+	// the table can be in use by tellListeners, so don't remove entries, just stop telling the listener
+	for (ListenerTable::iterator it = listener_table.begin() ; it != listener_table.end() ; ++it) {
+		std::replace(it->second.begin(), it->second.end(), listener, (ActionListener*)nullptr);
+	}
 }
+
 void ActionStack::tellListeners(const Action& action, bool undone) {
-	FOR_EACH(l, listeners) l->onAction(action, undone);
+	if (!listener_table_valid && telling_listeners == 0) {
+		listener_table.clear();
+		listener_table_valid = true;
+	}
+	if (!listener_table_valid) {
+		// a listener was added while telling others, the table can't be changed now
+		vector<ActionListener*> ls = listeners;
+		FOR_EACH(l, ls) {
+			// skip listeners that were removed by an earlier listener, they may have been destroyed
+			if (find(listeners.begin(), listeners.end(), l) == listeners.end()) continue;
+			if (l->listensTo(action)) {
+				l->actions_received++;
+				l->onAction(action, undone);
+			}
+		}
+		return;
+	}
+	// find the listeners for this type of action
+	ListenerTable::iterator it = listener_table.find(&typeid(action));
+	if (it == listener_table.end()) {
+		vector<ActionListener*> ls;
+		FOR_EACH(l, listeners) {
+			if (l->listensTo(action)) ls.push_back(l);
+		}
+		it = listener_table.insert(make_pair(&typeid(action), ls)).first;
+	}
+	// tell them, note: the vector can grow nulls but not change size while we are iterating
+	telling_listeners++;
+	try {
+		const vector<ActionListener*>& ls = it->second;
+		for (size_t i = 0 ; i < ls.size() ; ++i) {
+			if (!ls[i]) continue; // removed
+			ls[i]->actions_received++;
+			ls[i]->onAction(action, undone);
+		}
+	} catch (...) {
+		telling_listeners--;
+		throw;
+	}
+	telling_listeners--;
 }
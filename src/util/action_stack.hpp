@@ -12,6 +12,7 @@
 #include <util/prec.hpp>
 #include <util/string.hpp>
 #include <vector>
+#include <typeinfo>
 
 // ----------------------------------------------------------------------------- : Action
 
@@ -41,6 +42,18 @@ class Action {
 	 *  Or: return true and change this action to incorporate both actions
 	 */
 	virtual bool merge(const Action& action) { return false; }
+	
+	/// Another action has been added on top of this one.
+	/** The action has been performed, and will not be merged with anymore.
+	 *  This is an opportunity to switch to a more compact representation.
+	 *  Note that the action on top has already been performed as well.
+	 */
+	virtual void compact() {}
+	
+	/// Approximate number of bytes used by this action.
+	/** Used to limit the memory used by an ActionStack, actions that hold on to large values should override this.
+	 */
+	virtual size_t memoryUsage() const { return sizeof(Action); }
 };
 
 // ----------------------------------------------------------------------------- : Action listeners
@@ -48,11 +61,26 @@ class Action {
 /// Base class/interface for objects that listen to actions
 class ActionListener {
   public:
+	ActionListener() : actions_received(0) {}
 	virtual ~ActionListener() {}
 	/// Notification that an action a has been performed or undone
 	virtual void onAction(const Action& a, bool undone) = 0;
+	/// Is this listener interested in actions of the same type as a?
+	/** The answer is remembered by the ActionStack for each type of action,
+	 *  so it must depend only on the type of a, not on its contents.
+	 */
+	virtual bool listensTo(const Action& a) const { return true; }
+	
+	/// Number of actions this listener has been told about, for profiling
+	size_t actions_received;
 };
 
+/// Is an action of the given type (or a type derived from it)?
+template <typename Type>
+inline bool is_action(const Action& a) {
+	return dynamic_cast<const Type*>(&a) != nullptr;
+}
+
 // ----------------------------------------------------------------------------- : Action stack
 
 /// A stack of actions that can be done and undone.
@@ -98,12 +126,20 @@ class ActionStack {
 	/// Indicate that the file is at a savepoint.
 	void setSavePoint();
 	
+	/// Limit the memory used by the actions, in bytes, 0 for no limit
+	/** When there is not enough room the oldest actions are forgotten, the last action can always be undone. */
+	void setMemoryLimit(size_t limit);
+	/// Approximate memory used by the actions on the stack, in bytes
+	inline size_t memoryUsage() const { return memory_used; }
+	
 	/// Add an action listener
 	void addListener(ActionListener* listener);
 	/// Remove an action listener
 	void removeListener(ActionListener* listener);
-	/// Tell all listeners about an action
+	/// Tell all listeners that listen to this type of action about it
 	void tellListeners(const Action&, bool undone);
+	/// All listeners
+	inline const vector<ActionListener*>& getListeners() const { return listeners; }
 	
   private:
 	/// Actions to be undone.
@@ -114,10 +150,32 @@ class ActionStack {
 	vector<Action*> redo_actions;
 	/// Point at which the file was saved, corresponds to the top of the undo stack at that point
 	Action* save_point;
+	/// Has the action the file was saved at been forgotten?
+	bool save_point_lost;
 	/// Was the last thing the user did addAction? (as opposed to undo/redo)
 	bool last_was_add;
 	/// Objects that are listening to actions
 	vector<ActionListener*> listeners;
+	
+	struct TypeInfoLess {
+		inline bool operator () (const std::type_info* a, const std::type_info* b) const { return a->before(*b) != 0; }
+	};
+	typedef map<const std::type_info*, vector<ActionListener*>, TypeInfoLess> ListenerTable;
+	/// The listeners for each type of action that has been seen, a subset of listeners
+	ListenerTable listener_table;
+	/// Is the listener_table up to date with the listeners?
+	bool listener_table_valid;
+	/// Number of calls to tellListeners in progress
+	int  telling_listeners;
+	/// Memory used by all actions in undo_actions and redo_actions
+	size_t memory_used;
+	/// Maximum for memory_used, or 0
+	size_t memory_limit;
+	
+	/// Perform or undo an action, keeping track of the memory it uses
+	void perform(Action* action, bool to_undo);
+	/// Forget the oldest actions until we are within the memory limit
+	void limitMemory();
 };
 
 
@@ -113,6 +113,16 @@ class IndexMap : private vector<Value> {
 		}
 		return end();
 	}
+	/// Find a value given the key name, looking at position hint first
+	/** If the value is found, hint is set to its position, so repeated lookups of the same name are O(1) */
+	template <typename Name>
+	typename vector<Value>::const_iterator find(const Name& key, size_t& hint) const {
+		size_t guess = hint;
+		if (guess < size() && get_key_name(at(guess)) == key) return begin() + guess;
+		typename vector<Value>::const_iterator it = find(key);
+		if (it != end()) hint = it - begin();
+		return it;
+	}
 	
 	inline void swap(IndexMap& b) {
 		vector<Value>::swap(b);
@@ -33,8 +33,8 @@ template <> void GetDefaultMember::handle(const wxDateTime&   v) { value = to_sc
 
 // ----------------------------------------------------------------------------- : GetMember
 
-GetMember::GetMember(const String& name)
-	: target_name(name)
+GetMember::GetMember(const String& name, size_t* hint)
+	: target_name(name), hint(hint)
 {}
 
 // caused by the pattern: if (!reflector.isCompound()) { REFLECT_NAMELESS(stuff) }
@@ -68,7 +68,8 @@ class GetDefaultMember {
 class GetMember {
   public:
 	/// Construct a member getter that looks for the given name
-	GetMember(const String& name);
+	/** Optionally with a hint where to look in index maps, see IndexMap::find */
+	GetMember(const String& name, size_t* hint = nullptr);
 	
 	/// Tell the reflection code we are not reading
 	inline bool isReading() const { return false; }
@@ -96,11 +97,9 @@ class GetMember {
 	/// Handle an index map: investigate keys
 	template <typename K, typename V> void handle(const IndexMap<K,V>& m) {
 		if (gdm.result()) return;
-		for (typename IndexMap<K,V>::const_iterator it = m.begin() ; it != m.end() ; ++it) {
-			if (get_key_name(*it) == target_name) {
-				gdm.handle(*it);
-				return;
-			}
+		typename IndexMap<K,V>::const_iterator it = hint ? m.find(target_name, *hint) : m.find(target_name);
+		if (it != m.end()) {
+			gdm.handle(*it);
 		}
 	}
 	template <typename K, typename V> void handle(const DelayedIndexMaps<K,V>&);
@@ -108,6 +107,7 @@ class GetMember {
 	
   private:
 	const String& target_name;	///< The name we are looking for
+	size_t*       hint;			///< Where to look first in index maps (optional)
 	GetDefaultMember gdm;		///< Object to store and retrieve the value
 };
 
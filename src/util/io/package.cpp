@@ -26,7 +26,9 @@ IMPLEMENT_DYNAMIC_ARG(Package*, writing_package,   nullptr);
 IMPLEMENT_DYNAMIC_ARG(Package*, clipboard_package, nullptr);
 
 Package::Package()
-	: fileStream(nullptr)
+	: files_mutex(wxMUTEX_RECURSIVE)
+	, listed(true)
+	, fileStream(nullptr)
 	, zipStream (nullptr)
 {}
 
@@ -69,7 +71,7 @@ const String& Package::absoluteFilename() const {
 
 void Package::open(const String& n, bool fast) {
 	assert(!isOpened()); // not already opened
-	PROFILER(_("open package"));
+	PROFILER_STAGE(PROFILE_IO, _("open package"));
 	// get absolute path
 	wxFileName fn(n);
 	fn.Normalize();
@@ -82,7 +84,12 @@ void Package::open(const String& n, bool fast) {
 	if (wxDirExists(filename)) {
 		openDirectory(fast);
 	} else if (wxFileExists(filename)) {
-		openZipfile();
+		if (fast) {
+			// read the zip directory when a file is needed
+			listed = false;
+		} else {
+			openZipfile();
+		}
 	} else {
 		throw PackageNotFoundError(_("Package not found: '") + filename + _("'"));
 	}
@@ -106,6 +113,8 @@ void Package::save(bool remove_unused) {
 }
 
 void Package::saveAs(const String& name, bool remove_unused) {
+	PROFILER_STAGE(PROFILE_IO, _("save package"));
+	ensureListed();
 	// type of package
 	if (wxDirExists(name)) {
 		saveToDirectory(name, remove_unused, false);
@@ -118,12 +127,14 @@ void Package::saveAs(const String& name, bool remove_unused) {
 }
 
 void Package::saveCopy(const String& name) {
+	ensureListed();
 	saveToZipfile(name, true, true);
 	clearKeepFlag();
 }
 
 void Package::removeTempFiles(bool remove_unused) {
 	// cleanup : remove temp files, remove deleted files from the list
+	wxMutexLocker lock(files_mutex);
 	FileInfos::iterator it = files.begin();
 	while (it != files.end()) {
 		if (it->second.wasWritten()) {
@@ -203,8 +214,14 @@ InputStreamP Package::openIn(const String& file) {
 		Packaged* p = dynamic_cast<Packaged*>(this);
 		return package_manager.openFileFromPackage(p, file);
 	}
+	wxMutexLocker lock(files_mutex);
 	FileInfos::iterator it = files.find(normalize_internal_filename(file));
-	if (it == files.end()) {
+	if (it == files.end() && !listed && !wxFileExists(filename+_("/")+file)) {
+		// not a file in a directory package, maybe the zip directory has not been read yet
+		ensureListed();
+		it = files.find(normalize_internal_filename(file));
+	}
+	if (it == files.end() && listed) {
 		// does it look like a relative filename?
 		if (filename.find(_(".mse-")) != String::npos) {
 			throw PackageError(_ERROR_2_("file not found package like", file, filename));
@@ -240,6 +257,8 @@ OutputStreamP Package::openOut(const String& file) {
 
 String Package::nameOut(const String& file) {
 	assert(wxThread::IsMain()); // Writing should only be done from the main thread
+	wxMutexLocker lock(files_mutex);
+	ensureListed();
 	String name = normalize_internal_filename(file);
 	FileInfos::iterator it = files.find(name);
 	if (it == files.end()) {
@@ -261,6 +280,8 @@ String Package::nameOut(const String& file) {
 
 LocalFileName Package::newFileName(const String& prefix, const String& suffix) {
 	assert(wxThread::IsMain()); // Writing should only be done from the main thread
+	wxMutexLocker lock(files_mutex);
+	ensureListed(); // the new name must not clash with an existing file
 	String name;
 	UInt infix = 0;
 	while (true) {
@@ -282,6 +303,7 @@ LocalFileName Package::newFileName(const String& prefix, const String& suffix) {
 
 void Package::referenceFile(const String& file) {
 	if (file.empty()) return;
+	ensureListed();
 	FileInfos::iterator it = files.find(file);
 	if (it == files.end()) throw InternalError(_("referencing a nonexistant file"));
 	it->second.keep = true;
@@ -291,6 +313,7 @@ void Package::referenceFile(const String& file) {
 
 String Package::absoluteName(const String& file) {
 	assert(wxThread::IsMain());
+	ensureListed();
 	FileInfos::iterator it = files.find(normalize_internal_filename(file));
 	if (it == files.end()) {
 		throw FileNotFoundError(file, filename);
@@ -380,7 +403,30 @@ void Package::loadZipStream() {
 }
 
 void Package::openDirectory(bool fast) {
-	if (!fast) openSubdir(wxEmptyString);
+	if (fast) {
+		// list the files when they are needed
+		listed = false;
+		modified = max(modified, wxDateTime(file_modified_time(filename)));
+	} else {
+		openSubdir(wxEmptyString);
+	}
+}
+
+void Package::ensureListed() {
+	wxMutexLocker lock(files_mutex);
+	if (listed) return;
+	if (wxDirExists(filename)) {
+		listed = true;
+		openSubdir(wxEmptyString);
+	} else {
+		openZipfile();
+		listed = true;
+	}
+}
+
+const Package::FileInfos& Package::getFileInfos() const {
+	const_cast<Package*>(this)->ensureListed();
+	return files;
 }
 
 void Package::openSubdir(const String& name) {
@@ -503,7 +549,7 @@ Package::FileInfos::iterator Package::addFile(const String& name) {
 
 DateTime Package::modificationTime(const pair<String, FileInfo>& fi) const {
 	if (fi.second.wasWritten()) {
-		return wxFileName(fi.first).GetModificationTime();
+		return DateTime(); // not saved yet, the time of the package says nothing about this file
 	} else if (fi.second.zipEntry) {
 		return fi.second.zipEntry->GetDateTime();
 	} else if (wxFileExists(filename+_("/")+fi.first)) {
@@ -512,6 +558,12 @@ DateTime Package::modificationTime(const pair<String, FileInfo>& fi) const {
 		return DateTime((wxLongLong)0ul);
 	}
 }
+DateTime Package::modificationTime(const LocalFileName& file) const {
+	wxMutexLocker lock(files_mutex);
+	FileInfos::const_iterator it = files.find(file.fn);
+	if (it == files.end()) return DateTime();
+	return modificationTime(*it);
+}
 
 
 // ----------------------------------------------------------------------------- : Packaged
@@ -539,6 +591,8 @@ template <> void Writer::handle(const PackageDependency& dep) {
 }
 
 // note: reflection must be declared before it is used
+// note: reading just the header stops at the first other key with a block of children,
+//       so these keys must come before any such key (REFLECT_BASE(Packaged) goes first)
 IMPLEMENT_REFLECTION(Packaged) {
 	REFLECT(short_name);
 	REFLECT(full_name);
@@ -573,13 +627,13 @@ template <> void Reader::handle(JustAsPackageProxy& object) {
 }
 
 void Packaged::open(const String& package, bool just_header) {
-	Package::open(package);
+	Package::open(package, just_header);
 	fully_loaded = false;
-	PROFILER(just_header ? _("open package header") : _("open package fully"));
+	PROFILER_STAGE(PROFILE_IO, just_header ? _("open package header") : _("open package fully"));
 	if (just_header) {
 		// Read just the header (the part common to all Packageds)
 		InputStreamP stream = openIn(typeName());
-		Reader reader(*stream, this, absoluteFilename() + _("/") + typeName(), true);
+		Reader reader(*stream, this, absoluteFilename() + _("/") + typeName(), true, true);
 		try {
 			JustAsPackageProxy proxy(this);
 			reader.handle_greedy(proxy);
@@ -590,8 +644,22 @@ void Packaged::open(const String& package, bool just_header) {
 		loadFully();
 	}
 }
+void Packaged::openHeader(const String& package, const PackageHeader& header) {
+	Package::open(package, true);
+	fully_loaded = false;
+	version            = header.version;
+	compatible_version = header.compatible_version;
+	installer_group    = header.installer_group;
+	short_name         = header.short_name;
+	full_name          = header.full_name;
+	icon_filename      = header.icon_filename;
+	position_hint      = header.position_hint;
+	dependencies       = header.dependencies;
+}
+
 void Packaged::loadFully() {
 	if (fully_loaded) return;
+	ensureListed();
 	InputStreamP stream = openIn(typeName());
 	Reader reader(*stream, this, absoluteFilename() + _("/") + typeName());
 	try {
@@ -14,8 +14,10 @@
 #include <util/error.hpp>
 #include <util/file_utils.hpp>
 #include <util/vcs.hpp>
+#include <wx/thread.h>
 
 class Package;
+class PackageHeader;
 class wxFileInputStream;
 class wxZipInputStream;
 class wxZipEntry;
@@ -113,8 +115,9 @@ class Package : public IntrusivePtrVirtualBase {
 	/**
 	 * Should only be called when the package is constructed using the default constructor!
 	 * 
-	 * If 'fast' is set, then for directories a full directory listing is not performed.
-	 * This means that the file_infos will not be fully initialized.
+	 * If 'fast' is set, then for directories a full directory listing is not performed
+	 * until the list of files is needed, files can still be opened.
+	 * For zip files the zip directory is not read until a file is opened or the list is needed.
 	 * 
 	 * @pre open not called before [TODO]
 	 */
@@ -144,6 +147,10 @@ class Package : public IntrusivePtrVirtualBase {
 	inline InputStreamP openIn(const LocalFileName& file) {
 		return openIn(file.fn);
 	}
+	/// The time a file in the package was last modified
+	/** Returns an invalid time if the file is not in the package, if it was written but the package was not saved yet,
+	 *  or if the time can not be determined. */
+	DateTime modificationTime(const LocalFileName& file) const;
 
 	/// Open an output stream for a file in the package.
 	/// (changes are only committed with save())
@@ -227,12 +234,17 @@ class Package : public IntrusivePtrVirtualBase {
 	/// Information on files in the package
 	/** Note: must be public for DECLARE_TYPEOF to work */
 	typedef map<String, FileInfo> FileInfos;
-	inline const FileInfos& getFileInfos() const { return files; }
+	const FileInfos& getFileInfos() const;
 	/// When was a file last modified?
 	DateTime modificationTime(const pair<String, FileInfo>& fi) const;
   private:
 	/// All files in the package
 	FileInfos files;
+	/// Lock for the file list, files can be opened from worker threads while the main thread adds files
+	/** Recursive, because listing the files can happen while it is locked */
+	mutable wxMutex files_mutex;
+	/// Are all files listed? Not the case for packages opened with open(..,fast=true)
+	bool listed;
 	/// Filestream for reading zip files
 	wxFileInputStream* fileStream;
 	/// Filestream for reading zip files
@@ -241,6 +253,10 @@ class Package : public IntrusivePtrVirtualBase {
 	void loadZipStream();
 	void openDirectory(bool fast = false);
 	void openSubdir(const String&);
+  protected:
+	/// List all files in a directory or read the zip directory, if that hasn't happened yet
+	void ensureListed();
+  private:
 	void openZipfile();
 	void reopen();
 	void removeTempFiles(bool remove_unused);
@@ -293,6 +309,8 @@ class Packaged : public Package {
 	/** if just_header is true, then the package is not fully parsed.
 	 */
 	void open(const String& package, bool just_header = false);
+	/// Open a package without reading the header, it is taken from the header index instead
+	void openHeader(const String& package, const PackageHeader& header);
 	/// Ensure the package is fully loaded.
 	void loadFully();
 	void save();
@@ -22,6 +22,8 @@
 DECLARE_TYPEOF_COLLECTION(InstallablePackageP);
 DECLARE_TYPEOF_COLLECTION(PackageVersionP);
 DECLARE_TYPEOF_COLLECTION(PackageVersion::FileInfo);
+DECLARE_TYPEOF_COLLECTION(PackageHeaderP);
+DECLARE_TYPEOF(map<String COMMA PackageHeaderP>);
 
 // ----------------------------------------------------------------------------- : PackageManager : in memory
 
@@ -37,9 +39,12 @@ void PackageManager::init() {
 								wxStandardPaths::Get().GetUserDataDir());
 }
 void PackageManager::destroy() {
+	wxMutexLocker lock(mutex);
+	header_index.save();
 	loaded_packages.clear();
 }
 void PackageManager::reset() {
+	wxMutexLocker lock(mutex);
 	loaded_packages.clear();
 }
 
@@ -64,6 +69,7 @@ PackagedP PackageManager::openAny(const String& name_, bool just_header) {
 	}
 
 	// Is this package already loaded?
+	wxMutexLocker lock(mutex);
 	PackagedP& p = loaded_packages[filename];
 	if (!p) {
 		// load with the right type, based on extension
@@ -77,7 +83,17 @@ PackagedP PackageManager::openAny(const String& name_, bool just_header) {
 		else {
 			throw PackageError(_("Unrecognized package type: '") + fn.GetExt() + _("'\nwhile trying to open: ") + name);
 		}
-		p->open(filename, just_header);
+		if (just_header) {
+			PackageHeaderP header = header_index.find(filename);
+			if (header) {
+				p->openHeader(filename, *header);
+			} else {
+				p->open(filename, true);
+				header_index.store(*p);
+			}
+		} else {
+			p->open(filename);
+		}
 	} else if (!just_header) {
 		p->loadFully();
 	}
@@ -100,6 +116,8 @@ void PackageManager::findMatching(const String& pattern, vector<PackagedP>& out)
 		}
 		file = wxFindNextFile();
 	}
+	wxMutexLocker lock(mutex);
+	header_index.save();
 }
 
 InputStreamP PackageManager::openFileFromPackage(Packaged*& package, const String& name) {
@@ -196,6 +214,8 @@ void PackageManager::findAllInstalledPackages(vector<InstallablePackageP>& packa
 	packages.push_back(mse_installable_package());
 	// invariant: sorted:
 	sort(packages);
+	wxMutexLocker lock(mutex);
+	header_index.save();
 }
 
 bool PackageManager::install(const InstallablePackage& package) {
@@ -203,6 +223,111 @@ bool PackageManager::install(const InstallablePackage& package) {
 	return (install_local ? local : global).install(package);
 }
 
+// ----------------------------------------------------------------------------- : PackageHeaderIndex
+
+String user_settings_dir();
+
+/// The time to compare with PackageHeader::modified
+DateTime header_modified_time(const String& filename) {
+	time_t time = file_modified_time(filename);
+	if (wxDirExists(filename)) {
+		// the directory changes when files are added or removed, but not when the main file is edited
+		size_t pos = filename.rfind(_(".mse-"));
+		if (pos != String::npos) {
+			time = max(time, file_modified_time(filename + _("/") + filename.substr(pos + 5)));
+		}
+	}
+	return DateTime(time);
+}
+
+PackageHeader::PackageHeader(const Packaged& package)
+	: filename(package.absoluteFilename())
+	, modified(header_modified_time(package.absoluteFilename()))
+	, version(package.version)
+	, compatible_version(package.compatible_version)
+	, installer_group(package.installer_group)
+	, short_name(package.short_name)
+	, full_name(package.full_name)
+	, icon_filename(package.icon_filename)
+	, position_hint(package.position_hint)
+	, dependencies(package.dependencies)
+{}
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(PackageHeader) {
+	REFLECT_NO_SCRIPT(filename);
+	REFLECT_NO_SCRIPT(modified);
+	REFLECT_NO_SCRIPT(version);
+	REFLECT_NO_SCRIPT(compatible_version);
+	REFLECT_NO_SCRIPT(installer_group);
+	REFLECT_NO_SCRIPT(short_name);
+	REFLECT_NO_SCRIPT(full_name);
+	REFLECT_NO_SCRIPT(icon_filename);
+	REFLECT_NO_SCRIPT(position_hint);
+	REFLECT_NO_SCRIPT_N("depends_ons", dependencies);
+}
+
+PackageHeaderP PackageHeaderIndex::find(const String& filename) {
+	load();
+	map<String,PackageHeaderP>::const_iterator it = headers.find(filename);
+	if (it == headers.end()) return PackageHeaderP();
+	if (it->second->modified.GetTicks() != header_modified_time(filename).GetTicks()) {
+		return PackageHeaderP(); // changed since indexing
+	}
+	return it->second;
+}
+
+void PackageHeaderIndex::store(const Packaged& package) {
+	load();
+	headers[package.absoluteFilename()] = intrusive(new PackageHeader(package));
+	changed = true;
+}
+
+IMPLEMENT_REFLECTION_NO_SCRIPT(PackageHeaderIndex) {
+	REFLECT_NO_SCRIPT(packages);
+}
+
+void PackageHeaderIndex::load() {
+	if (loaded) return;
+	loaded = true;
+	String filename = indexFile();
+	if (!wxFileExists(filename)) return;
+	wxFileInputStream file(filename);
+	if (!file.Ok()) return; // failure is not an error, the index is rebuilt
+	try {
+		Reader reader(file, nullptr, filename);
+		reader.handle_greedy(*this);
+		FOR_EACH(p, packages) {
+			headers[p->filename] = p;
+		}
+	} catch (const Error&) {}
+	packages.clear();
+}
+
+void PackageHeaderIndex::save() {
+	if (!changed) return;
+	changed = false;
+	// forget about packages that are no longer there
+	for (map<String,PackageHeaderP>::iterator it = headers.begin() ; it != headers.end() ; ) {
+		if (!wxFileExists(it->first) && !wxDirExists(it->first)) {
+			headers.erase(it++);
+		} else {
+			++it;
+		}
+	}
+	wxFileOutputStream stream(indexFile());
+	if (!stream.IsOk()) return;
+	FOR_EACH(h, headers) {
+		packages.push_back(h.second);
+	}
+	Writer writer(stream, app_version);
+	writer.handle(*this);
+	packages.clear();
+}
+
+String PackageHeaderIndex::indexFile() const {
+	return user_settings_dir() + _("/package-headers");
+}
+
 // ----------------------------------------------------------------------------- : PackageDirectory
 
 void PackageDirectory::init(bool local) {
@@ -287,7 +412,11 @@ void PackageDirectory::installedPackages(vector<InstallablePackageP>& packages_o
 			// ok, a package already in the db
 			try {
 				PackagedP pack = package_manager.openAny(*it2, true);
-				(*it1)->check_status(*pack);
+				if ((*it1)->needs_check(*pack)) {
+					// don't list all files of packages that were not touched since the last check
+					(*it1)->check_status(*pack);
+					db_changed = true;
+				}
 				packages_out.push_back(intrusive(new InstallablePackage(intrusive(new PackageDescription(*pack)), *it1)));
 			} catch (const Error&) { db_changed = true; }
 			++it1, ++it2;
@@ -446,14 +575,21 @@ IMPLEMENT_REFLECTION_NO_SCRIPT(PackageVersion) {
 	REFLECT_NO_SCRIPT(name);
 	REFLECT_NO_SCRIPT(version);
 	REFLECT_NO_SCRIPT(status);
+	REFLECT_NO_SCRIPT(checked);
 	REFLECT_NO_SCRIPT(files);
 }
 
+bool PackageVersion::needs_check(const Packaged& package) const {
+	return !checked.IsValid()
+	    || checked.GetTicks() != header_modified_time(package.absoluteFilename()).GetTicks();
+}
+
 void PackageVersion::check_status(Packaged& package) {
 	status &= ~STATUS_MODIFIED;
 	if (!(status & STATUS_BLESSED)) status |= STATUS_MODIFIED;
 	name    = package.relativeFilename();
 	version = package.version;
+	checked = header_modified_time(package.absoluteFilename());
 	// Merge our files list with the list from the package
 	vector<FileInfo> new_files;
 	Package::FileInfos fis = package.getFileInfos();
@@ -467,9 +603,9 @@ void PackageVersion::check_status(Packaged& package) {
 			if (mtime != it2->time) {
 				it2->time   = mtime;
 				it2->status = FILE_MODIFIED;
-				new_files.push_back(*it2);
 				status |= STATUS_MODIFIED;
 			}
+			new_files.push_back(*it2);
 			++it1; ++it2;
 		} else if (it1 != fis.end() && (it2 == files.end() || it1->first < it2->file)) {
 			// this is a new file
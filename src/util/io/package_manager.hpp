@@ -12,10 +12,12 @@
 #include <util/prec.hpp>
 #include <util/io/package.hpp>
 #include <wx/filename.h>
+#include <wx/thread.h>
 
 DECLARE_POINTER_TYPE(Packaged);
 DECLARE_POINTER_TYPE(PackageVersion);
 DECLARE_POINTER_TYPE(InstallablePackage);
+DECLARE_POINTER_TYPE(PackageHeader);
 class PackageDependency;
 
 // ----------------------------------------------------------------------------- : PackageVersion
@@ -101,6 +103,54 @@ class PackageDirectory {
 	DECLARE_REFLECTION();
 };
 
+// ----------------------------------------------------------------------------- : PackageHeaderIndex
+
+/// The header of an installed package, as stored in the PackageHeaderIndex
+class PackageHeader : public IntrusivePtrBase<PackageHeader> {
+  public:
+	PackageHeader() : position_hint(0) {}
+	PackageHeader(const Packaged& package);
+	
+	String   filename;				///< Absolute filename of the package
+	DateTime modified;				///< Modification time of the package when the header was read
+	Version  version;
+	Version  compatible_version;
+	String   installer_group;
+	String   short_name;
+	String   full_name;
+	String   icon_filename;
+	int      position_hint;
+	vector<PackageDependencyP> dependencies;
+	
+	DECLARE_REFLECTION();
+};
+
+/// A persistent index of the headers of installed packages
+/** Listing packages only needs their headers, with the index these don't have to be read from the packages.
+ *  An entry is valid as long as the modification time of the package file is unchanged,
+ *  for directories the time of the directory itself and of the main file are used.
+ */
+class PackageHeaderIndex {
+  public:
+	PackageHeaderIndex() : loaded(false), changed(false) {}
+	
+	/// Find the header of a package, returns nullptr if the package is not indexed or has changed since
+	PackageHeaderP find(const String& filename);
+	/// Store the header of a package that was just read
+	void store(const Packaged& package);
+	/// Write the index to disk, if it has changed
+	void save();
+	
+  private:
+	bool loaded, changed;
+	map<String,PackageHeaderP> headers;	///< Headers by filename
+	vector<PackageHeaderP>     packages;	///< The headers as they are stored in the index file
+	
+	void load();
+	String indexFile() const;
+	DECLARE_REFLECTION();
+};
+
 // ----------------------------------------------------------------------------- : PackageManager
 
 /// Package manager, loads data files from the default data directory.
@@ -109,6 +159,8 @@ class PackageDirectory {
  */
 class PackageManager {
   public:
+	PackageManager() : mutex(wxMUTEX_RECURSIVE) {}
+	
 	/// Initialize the package manager
 	void init();
 	/// Empty the list of packages.
@@ -178,8 +230,12 @@ class PackageManager {
 	// --------------------------------------------------- : Packages on a server
 	
   private:
+	/// Lock for loaded_packages, packages can be opened from worker threads (thumbnails, export)
+	/** Recursive, because opening a package opens its dependencies */
+	wxMutex mutex;
 	map<String, PackagedP> loaded_packages;
 	PackageDirectory local, global;
+	PackageHeaderIndex header_index;
 };
 
 /// The global PackageManager instance
@@ -204,9 +260,13 @@ class PackageVersion : public IntrusivePtrBase<PackageVersion> {
 	,	STATUS_FIXED    = 0x40 ///< The package can not be uninstalled
 	};
 	int status;
+	DateTime checked; ///< Modification time of the package when the files were last checked
 	
 	/// Check the status of the files in this package
 	void check_status(Packaged& package);
+	/// Can the package have changed since the last check_status?
+	/** Only looks at the modification time of the package, see header_modified_time */
+	bool needs_check(const Packaged& package) const;
 	/// Set blessed status to true
 	void bless();
 	
@@ -21,9 +21,9 @@ IMPLEMENT_DYNAMIC_ARG(ReaderPragmaHandler,reader_pragma_handler,nullptr);
 
 // ----------------------------------------------------------------------------- : Reader
 
-Reader::Reader(InputStream& input, Packaged* package, const String& filename, bool ignore_invalid)
+Reader::Reader(InputStream& input, Packaged* package, const String& filename, bool ignore_invalid, bool header_only)
 	: indent(0), expected_indent(0), state(OUTSIDE)
-	, ignore_invalid(ignore_invalid)
+	, ignore_invalid(ignore_invalid), header_only(header_only)
 	, filename(filename), package(package), line_number(0), previous_line_number(0)
 	, input(input)
 {
@@ -251,9 +251,16 @@ void Reader::readLine(bool in_string) {
 void Reader::unknownKey() {
 	// ignore?
 	if (ignore_invalid) {
-		do {
+		moveNext();
+		if (header_only && expected_indent == 0 && indent > 0) {
+			// the first block that is not part of the header, stop reading here
+			key.clear();
+			indent = -1;
+			return;
+		}
+		while (indent > expected_indent) {
 			moveNext();
-		} while (indent > expected_indent);
+		}
 		return;
 	}
 	if (indent >= expected_indent) {
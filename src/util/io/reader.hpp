@@ -40,8 +40,10 @@ class Reader {
 	/// Construct a reader that reads from the given input stream
 	/** filename is used only for error messages.
 	 *  package is used for looking up included files.
+	 *  If header_only is set, reading stops at the first unknown top level key that has a block of children,
+	 *  this requires ignore_invalid. See Packaged for the keys that make up a header.
 	 */
-	Reader(InputStream& input, Packaged* package = nullptr, const String& filename = wxEmptyString, bool ignore_invalid = false);
+	Reader(InputStream& input, Packaged* package = nullptr, const String& filename = wxEmptyString, bool ignore_invalid = false, bool header_only = false);
 	
 	~Reader() { showWarnings(); }
 	
@@ -136,6 +138,8 @@ class Reader {
 	} state;
 	/// Should all invalid keys be ignored?
 	bool ignore_invalid;
+	/// Stop reading after the header?
+	bool header_only;
 	
 	/// Filename for error messages
 	String filename;
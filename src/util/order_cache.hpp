@@ -14,7 +14,10 @@
 // ----------------------------------------------------------------------------- : OrderCache
 
 /// Object that cashes an ordered version of a list of items, for finding the position of objects
-/** Can be used as a map "void* -> int" for finding the position of an object */
+/** Can be used as a map "void* -> int" for finding the position of an object.
+ *  The value of a single key can be changed afterwards with update(), which moves only that key,
+ *  so the cache does not have to be rebuilt when one item changes.
+ */
 template <typename T>
 class OrderCache : public IntrusivePtrBase<OrderCache<T> > {
   public:
@@ -27,29 +30,42 @@ class OrderCache : public IntrusivePtrBase<OrderCache<T> > {
 	/// Find the position of the given key in the cache, returns -1 if not found
 	int find(const T& key) const;
 	
+	/// Change the value of a key, and whether it is kept by the filter
+	/** Returns false if the key is not in the cache */
+	bool update(const T& key, const String& value, bool keep = true);
+	
   private:
+	struct Item {
+		void*  key;
+		String value;
+		int    index;    ///< Index in the original list, to break ties
+		int    position; ///< Position in the sorted list, or -1 if not kept
+	};
 	struct CompareKeys;
 	struct CompareValues;
-	typedef pair<void*,int> KV;
-	vector<KV> positions;
+	vector<Item>  items;	///< All items, sorted by key
+	vector<Item*> order;	///< The kept items, sorted by value
+	
+	Item* findItem(void* key);
+	/// Update the position of items in order[begin..end)
+	void renumber(size_t begin, size_t end);
 };
 
 // ----------------------------------------------------------------------------- : Implementation
 
 template <typename T>
 struct OrderCache<T>::CompareKeys {
-	inline bool operator () (const KV& a, void*     b) { return a.first < b; }
-	inline bool operator () (const KV& a, const KV& b) { return a.first < b.first; }
-	inline bool operator () (void*     a, const KV& b) { return a       < b.first; }
+	inline bool operator () (const Item& a, void*       b) { return a.key < b; }
+	inline bool operator () (const Item& a, const Item& b) { return a.key < b.key; }
+	inline bool operator () (void*       a, const Item& b) { return a     < b.key; }
 };
 
 template <typename T>
 struct OrderCache<T>::CompareValues {
-	const vector<String>& values;
-	CompareValues(const vector<String>& values) : values(values) {}
-	
-	inline bool operator () (const KV& a, const KV& b) {
-		return smart_less(values[a.second], values[b.second]);
+	inline bool operator () (const Item* a, const Item* b) {
+		if (smart_less(a->value, b->value)) return true;
+		if (smart_less(b->value, a->value)) return false;
+		return a->index < b->index;
 	}
 };
 
@@ -57,30 +73,69 @@ template <typename T>
 OrderCache<T>::OrderCache(const vector<T>& keys, const vector<String>& values, vector<int>* keep) {
 	assert(keys.size() == values.size());
 	assert(!keep || keep->size() == keys.size());
-	// initialize positions, use pos to point back to the values vector
-	positions.reserve(keys.size());
-	int i = 0;
-	for (typename vector<T>::const_iterator it = keys.begin() ; it != keys.end() ; ++it, ++i) {
-		if (!keep || (*keep)[i]) {
-			positions.push_back(KV(&**it, i));
-		}
+	// initialize items, sorted by key so we can find them
+	items.resize(keys.size());
+	for (size_t i = 0 ; i < keys.size() ; ++i) {
+		Item& item = items[i];
+		item.key      = &*keys[i];
+		item.value    = values[i];
+		item.index    = (int)i;
+		item.position = !keep || (*keep)[i] ? 0 : -1;
 	}
-	// sort the KVs by the values
-	sort(positions.begin(), positions.end(), CompareValues(values));
-	// update positions, to point to sorted list
-	i = 0;
-	for (typename vector<KV>::iterator it = positions.begin() ; it != positions.end() ; ++it, ++i) {
-		it->second = i;
+	sort(items.begin(), items.end(), CompareKeys());
+	// sort the kept items by the values
+	order.reserve(items.size());
+	for (typename vector<Item>::iterator it = items.begin() ; it != items.end() ; ++it) {
+		if (it->position >= 0) order.push_back(&*it);
 	}
-	// sort the KVs by the keys
-	sort(positions.begin(), positions.end(), CompareKeys());
+	sort(order.begin(), order.end(), CompareValues());
+	renumber(0, order.size());
+}
+
+template <typename T>
+typename OrderCache<T>::Item* OrderCache<T>::findItem(void* key) {
+	typename vector<Item>::iterator it = lower_bound(items.begin(), items.end(), key, CompareKeys());
+	if (it == items.end() || it->key != key) return nullptr;
+	return &*it;
 }
 
 template <typename T>
 int OrderCache<T>::find(const T& key) const {
-	vector<KV>::const_iterator it = lower_bound(positions.begin(), positions.end(), &*key, CompareKeys());
-	if (it == positions.end() || it->first != &*key) return -1;
-	return it->second;
+	typename vector<Item>::const_iterator it = lower_bound(items.begin(), items.end(), (void*)&*key, CompareKeys());
+	if (it == items.end() || it->key != &*key) return -1;
+	return it->position;
+}
+
+template <typename T>
+bool OrderCache<T>::update(const T& key, const String& value, bool keep) {
+	Item* item = findItem(&*key);
+	if (!item) return false;
+	int old_pos = item->position;
+	if ((old_pos >= 0) == keep && item->value == value) return true; // nothing changed
+	// remove from old position
+	if (old_pos >= 0) order.erase(order.begin() + old_pos);
+	item->value    = value;
+	item->position = -1;
+	// insert at new position
+	int new_pos = -1;
+	if (keep) {
+		new_pos = int(upper_bound(order.begin(), order.end(), item, CompareValues()) - order.begin());
+		order.insert(order.begin() + new_pos, item);
+	}
+	// only the items between the old and new position have moved
+	if (old_pos >= 0 && new_pos >= 0) {
+		renumber(min(old_pos, new_pos), max(old_pos, new_pos) + 1);
+	} else {
+		renumber(max(old_pos, new_pos), order.size());
+	}
+	return true;
+}
+
+template <typename T>
+void OrderCache<T>::renumber(size_t begin, size_t end) {
+	for (size_t i = begin ; i < end ; ++i) {
+		order[i]->position = (int)i;
+	}
 }
 
 // ----------------------------------------------------------------------------- : EOF
@@ -13,6 +13,45 @@
 #if USE_BOOST_REGEX
 // ----------------------------------------------------------------------------- : Regex : boost
 
+/// The literal text at the start of a regular expression, that every match must start with
+/** Returns "" if there is no such text, for instance when the regex contains a top level alternative
+ */
+String regex_literal_prefix(const String& code) {
+	// there must not be a top level '|'
+	int depth = 0;
+	for (size_t i = 0 ; i < code.size() ; ++i) {
+		Char c = code.GetChar(i);
+		if (c == _('\\')) {
+			++i; // skip escaped character
+		} else if (c == _('[')) {
+			// skip character class, a ']' directly after the '[' or '[^' is part of the class
+			++i;
+			if (i < code.size() && code.GetChar(i) == _('^')) ++i;
+			if (i < code.size() && code.GetChar(i) == _(']')) ++i;
+			while (i < code.size() && code.GetChar(i) != _(']')) {
+				if (code.GetChar(i) == _('\\')) ++i;
+				++i;
+			}
+		} else if (c == _('(')) {
+			++depth;
+		} else if (c == _(')')) {
+			--depth;
+		} else if (c == _('|') && depth <= 0) {
+			return String();
+		}
+	}
+	// take characters up to the first special one
+	size_t end = 0;
+	while (end < code.size() && !wxStrchr(_(".[]{}()\\*+?|^$#"), code.GetChar(end))) {
+		++end;
+	}
+	// a quantifier applies to the last character, so that one is optional
+	if (end < code.size() && wxStrchr(_("*?{"), code.GetChar(end)) && end > 0) {
+		--end;
+	}
+	return code.substr(0, end);
+}
+
 void Regex::assign(const String& code) {
 	// compile string
 	try {
@@ -22,12 +61,15 @@ void Regex::assign(const String& code) {
 		throw ScriptError(String::Format(_("Error while compiling regular expression: '%s'\nAt position: %d\n%s"),
 		                  code.c_str(), e.position(), String(e.what(), IF_UNICODE(wxConvUTF8,String::npos)).c_str()));
 	}
+	literal_prefix = regex_literal_prefix(code);
 }
 
 void Regex::replace_all(String* input, const String& format) {
+	if (!mayMatch(input->begin(), input->end())) return; // nothing to replace
 	//std::basic_string<Char> fmt; format_string(format,fmt);
 	std::basic_string<Char> fmt(format.begin(),format.end());
 	String output;
+	output.reserve(input->size());
 	regex_replace(insert_iterator<String>(output, output.end()),
 	              input->begin(), input->end(), regex, fmt, boost::format_sed);
 	*input = output;
@@ -59,22 +59,42 @@
 		
 		void assign(const String& code);
 		inline bool matches(const String& str) const {
-			return regex_search(str.begin(), str.end(), regex);
+			return mayMatch(str.begin(), str.end()) && regex_search(str.begin(), str.end(), regex);
 		}
 		inline bool matches(Results& results, const String& str, size_t start = 0) const {
 			return matches(results, str.begin() + start, str.end());
 		}
 		inline bool matches(Results& results, const String::const_iterator& begin, const String::const_iterator& end) const {
-			return regex_search(begin, end, results, regex);
+			return mayMatch(begin, end) && regex_search(begin, end, results, regex);
+		}
+		/// Match only at the start of the range, without searching the rest of it
+		inline bool matchesAt(Results& results, const String::const_iterator& begin, const String::const_iterator& end) const {
+			if (!literal_prefix.empty() &&
+			    ((size_t)(end - begin) < literal_prefix.size() || !equal(literal_prefix.begin(), literal_prefix.end(), begin))) {
+				return false;
+			}
+			return regex_search(begin, end, results, regex, boost::match_continuous);
 		}
 		void replace_all(String* input, const String& format);
 		
 		inline bool empty() const {
 			return regex.empty();
 		}
+		/// Literal text that every match starts with, or an empty string if this is not known
+		inline const String& literalPrefix() const {
+			return literal_prefix;
+		}
 		
 	  private:
 		boost::basic_regex<Char> regex; ///< The regular expression
+		String literal_prefix;          ///< Literal text that every match starts with, if any
+		
+		/// Can the regex match somewhere in the given range? Quick check using the literal prefix
+		inline bool mayMatch(const String::const_iterator& begin, const String::const_iterator& end) const {
+			if (literal_prefix.empty()) return true;
+			if (literal_prefix.size() == 1) return find(begin, end, literal_prefix[0]) != end;
+			return search(begin, end, literal_prefix.begin(), literal_prefix.end()) != end;
+		}
 	};
 
 // ----------------------------------------------------------------------------- : Wx implementation
@@ -146,12 +166,18 @@
 			results.begin = begin;
 			return regex.Matches(begin, 0, end - begin);
 		}
+		inline bool matchesAt(Results& results, const Char* begin, const Char* end) const {
+			return matches(results, begin, end) && results.position() == 0;
+		}
 		inline void replace_all(String* input, const String& format) {
 			regex.Replace(input, format);
 		}
 		inline bool empty() const {
 			return !regex.IsValid();
 		}
+		inline String literalPrefix() const {
+			return String();
+		}
 		
 	  private:
 		wxRegEx regex; ///< The regular expression
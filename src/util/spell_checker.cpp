@@ -14,8 +14,10 @@
 // ----------------------------------------------------------------------------- : Spell checker : construction
 
 map<String,SpellCheckerP> SpellChecker::spellers;
+wxMutex SpellChecker::spellers_mutex;
 
 SpellChecker& SpellChecker::get(const String& language) {
+	wxMutexLocker lock(spellers_mutex);
 	SpellCheckerP& speller = spellers[language];
 	if (!speller) {
 		String local_dir  = package_manager.getDictionaryDir(true);
@@ -36,6 +38,7 @@ SpellChecker& SpellChecker::get(const String& language) {
 }
 
 SpellChecker& SpellChecker::get(const String& filename, const String& language) {
+	wxMutexLocker lock(spellers_mutex);
 	SpellCheckerP& speller = spellers[filename + _(".") + language];
 	if (!speller) {
 		Packaged* package = nullptr;
@@ -66,6 +69,7 @@ SpellChecker::SpellChecker(const char* aff_path, const char* dic_path)
 {}
 
 void SpellChecker::destroyAll() {
+	wxMutexLocker lock(spellers_mutex);
 	spellers.clear();
 }
 
@@ -107,9 +111,15 @@ bool SpellChecker::convert_encoding(const String& word, CharBuffer& out) {
 
 bool SpellChecker::spell(const String& word) {
 	if (word.empty()) return true; // empty word is okay
+	wxMutexLocker lock(mutex);
+	map<String,bool>::const_iterator it = cache.find(word);
+	if (it != cache.end()) return it->second;
+	// not seen before
 	CharBuffer str;
-	if (!convert_encoding(word,str)) return false;
-	return Hunspell::spell(str);
+	bool correct = convert_encoding(word,str) && Hunspell::spell(str);
+	if (cache.size() >= 100000) cache.clear(); // don't let the cache grow without bound
+	cache.insert(make_pair(word, correct));
+	return correct;
 }
 
 bool SpellChecker::spell_with_punctuation(const String& word) {
@@ -120,6 +130,7 @@ bool SpellChecker::spell_with_punctuation(const String& word) {
 }
 
 void SpellChecker::suggest(const String& word, vector<String>& suggestions_out) {
+	wxMutexLocker lock(mutex);
 	CharBuffer str;
 	if (!convert_encoding(word,str)) return;
 	// call Hunspell
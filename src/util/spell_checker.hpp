@@ -24,15 +24,16 @@ DECLARE_POINTER_TYPE(SpellChecker);
 // ----------------------------------------------------------------------------- : Spell checker
 
 /// A spelling checker for a particular language
+/** The results for words are cached, and all functions can be used from multiple threads.
+ */
 class SpellChecker : public Hunspell, public IntrusivePtrBase<SpellChecker> {
   public:
 	/// Get a SpellChecker object for the given language.
-	/** Note: This is not threadsafe yet */
 	static SpellChecker& get(const String& language);
 	/// Get a SpellChecker object for the given language and filename
-	/** Note: This is not threadsafe yet */
 	static SpellChecker& get(const String& filename, const String& language);
 	/// Destroy all cached SpellChecker objects
+	/** Note: Must not be called while other threads are using them */
 	static void destroyAll();
 
 	/// Check the spelling of a single word
@@ -47,9 +48,14 @@ class SpellChecker : public Hunspell, public IntrusivePtrBase<SpellChecker> {
 	/// Convert between String and dictionary encoding
 	wxCSConv encoding;
 	bool convert_encoding(const String& word, CharBuffer& out);
+	/// Results of spell() for words that were checked before
+	map<String,bool> cache;
+	/// Guards the cache and calls to Hunspell
+	wxMutex mutex;
 
 	SpellChecker(const char* aff_path, const char* dic_path);
 	static map<String,SpellCheckerP> spellers; //< Cached checkers for each language
+	static wxMutex spellers_mutex;             //< Guards spellers
 };
 
 // ----------------------------------------------------------------------------- : EOF
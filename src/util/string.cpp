@@ -98,6 +98,14 @@ String replace_all(const String& heystack, const String& needle, const String& r
 	return ret;
 }
 
+String hash_string(const String& str, unsigned int seed) {
+	unsigned int h = seed;
+	FOR_EACH_CONST(c, str) {
+		h = (h ^ (unsigned int)c) * 16777619u;
+	}
+	return String::Format(_("%08x"), h);
+}
+
 // ----------------------------------------------------------------------------- : Words
 
 String last_word(const String& s) {
@@ -138,6 +146,12 @@ bool is_word_end_punctuation(Char c) {
 	return word_end_chars.find_first_of(c) != String::npos;
 }
 
+bool is_word_end(const String& s, size_t pos) {
+	if (pos == 0 || pos >= s.size()) return true;
+	Char c = s.GetChar(pos);
+	return isSpace(c) || isPunct(c);
+}
+
 // ----------------------------------------------------------------------------- : Caseing
 
 /// Quick check to see if the substring starting at the given iterator is equal to some given string
@@ -394,6 +408,34 @@ int smart_compare(const String& sa, const String& sb) {
 		     : na - pa <  nb - pb ? -1 : 1; // outside number, shorter string comes first
 	}
 }
+String smart_sort_key(const String& s) {
+	String key;
+	key.reserve(s.size() + 2);
+	size_t n = s.size();
+	for (size_t i = 0 ; i < n ; ) {
+		Char c = s.GetChar(i);
+		if (isDigit(c)) {
+			// a number: marker, length, digits
+			size_t end = i + 1;
+			while (end < n && isDigit(s.GetChar(end))) ++end;
+			key += _('0');
+			key += (Char)min(end - i, (size_t)0xFFFF);
+			key.append(s, i, end - i);
+			i = end;
+		} else if (c >= 0x20) {
+			key += remove_accents(c);
+			Char c2 = decompose_char2(c);
+			if (c2) key += c2;
+			++i;
+		} else {
+			// control characters
+			key += c;
+			++i;
+		}
+	}
+	return key;
+}
+
 bool smart_less(const String& sa, const String& sb) {
 	return smart_compare(sa, sb) == -1;
 }
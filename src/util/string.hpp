@@ -128,6 +128,10 @@ String substr_replace(const String& input, size_t start, size_t end, const Strin
 /// Replace all occurences of one needle with replacement
 String replace_all(const String& heystack, const String& needle, const String& replacement);
 
+/// Hash of a string as 8 hexadecimal digits, for use in cache keys and filenames
+/** Different seeds give independent hashes */
+String hash_string(const String& str, unsigned int seed = 2166136261u);
+
 // ----------------------------------------------------------------------------- : Words
 
 /// Returns the last word in a string
@@ -142,6 +146,9 @@ void trim_punctuation(const String&, size_t& start, size_t& end);
 bool is_word_start_punctuation(Char c);
 bool is_word_end_punctuation(Char c);
 
+/// Can a word start or end at position pos in s? That is the case at the ends of the string, and at whitespace or punctuation
+bool is_word_end(const String& s, size_t pos);
+
 // ----------------------------------------------------------------------------- : Caseing
 
 /// Make each word in a string start with an upper case character.
@@ -188,6 +195,14 @@ bool smart_less(const String&, const String&);
 /// Compare two strings for equality
 bool smart_equal(const String&, const String&);
 
+/// A key for sorting strings, comparing two keys with compare() gives the same order as smart_compare
+/** Numbers are prefixed by their length, letters are lower cased, accents are removed and
+ *  composed characters are decomposed.
+ *  Computing the key is more expensive than a single smart_compare, so this is only worth it if
+ *  the key is used for many comparisons, i.e. when sorting.
+ */
+String smart_sort_key(const String&);
+
 /// Return whether str starts with start
 /** starts_with(a,b) == is_substr(a,0,b) */
 bool starts_with(const String& str, const String& start);
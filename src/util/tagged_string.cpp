@@ -25,6 +25,11 @@ Char tag_char(Char c) {
 
 
 String untag(const String& str) {
+	if (str.find_first_of(_('<'))           == String::npos &&
+	    str.find_first_of(_('\1'))          == String::npos &&
+	    str.find_first_of(CONNECTION_SPACE) == String::npos) {
+		return str; // nothing to untag, no need to copy
+	}
 	bool intag = false;
 	String ret; ret.reserve(str.size());
 	FOR_EACH_CONST(c, str) {
@@ -36,6 +41,7 @@ String untag(const String& str) {
 }
 
 String untag_no_escape(const String& str) {
+	if (str.find_first_of(_('<')) == String::npos) return str; // no need to copy
 	bool intag = false;
 	String ret; ret.reserve(str.size());
 	FOR_EACH_CONST(c, str) {
@@ -51,6 +57,7 @@ String untag_hide_sep(const String& str) {
 }
 
 String escape(const String& str) {
+	if (str.find_first_of(_('<')) == String::npos) return str; // no need to copy
 	String ret; ret.reserve(str.size());
 	FOR_EACH_CONST(c, str) {
 		ret += tag_char(c);
@@ -201,6 +208,63 @@ String anti_tag(const String& tag) {
 
 // ----------------------------------------------------------------------------- : Cursor position
 
+/// index_to_cursor for an index inside the atom that starts at position i and has the given cursor position
+static size_t index_to_cursor_in_atom(const String& str, size_t i, size_t index, size_t cursor, Movement dir) {
+	size_t close = match_close_tag(str, i);
+	Char c;
+	// Index is inside an atom, determine on which side we want the cursor
+	// This is the only place where MOVE_LEFT/RIGHT and MOVE_*_OPT differ
+	// for the OPT version we must check if we are actually past any real characters
+	// but, if the atom is empty, it still counts as a single character!
+	if (dir == MOVE_LEFT) {
+		return cursor;
+	} else if (dir == MOVE_RIGHT) {
+		return cursor + 1;
+	} else if (dir == MOVE_LEFT_OPT) {
+		// is there any non-tag after index?
+		bool empty = true;
+		while (i < close) {
+			c = str.GetChar(i);
+			if (c == _('<')) {
+				i = skip_tag(str, i);
+			} else if (i >= index) {
+				return cursor; // this is a non-tag character after index
+			} else {
+				empty = false;
+				++i;
+			}
+		}
+		return empty ? cursor : cursor + 1; // still didn't pass any
+	} else if (dir == MOVE_RIGHT_OPT) {
+		// is index actually past any non-tag?
+		while (i < close) {
+			if (i >= index) {
+				return cursor; // we didn't pass any non-tag stuff
+			}
+			c = str.GetChar(i);
+			if (c != _('<')) break;
+			i = skip_tag(str, i);
+		}
+		return cursor + 1; // yes it is
+	} else {
+		// count number of actual characters before/after
+		int before_c = 0;
+		int after_c  = 0;
+		while (i < close) {
+			c = str.GetChar(i);
+			if (c == _('<')) {
+				i = skip_tag(str, i);
+			} else {
+				if (i < index) before_c++;
+				else           after_c++;
+				++i;
+			}
+		}
+		// take the closest side
+		return before_c <= after_c ? cursor : cursor + 1;
+	}
+}
+
 size_t index_to_cursor(const String& str, size_t index, Movement dir) {
 	size_t cursor = 0;
 	index = min(index, str.size());
@@ -214,60 +278,9 @@ size_t index_to_cursor(const String& str, size_t index, Movement dir) {
 			if (is_substr(str, i, _("<atom")) || is_substr(str, i, _("<sep"))) {
 				// skip tag contents, tag counts as a single 'character'
 				size_t before = i;
-				size_t close = match_close_tag(str, i);
-				size_t after = skip_tag(str, close);
+				size_t after = match_close_tag_end(str, i);
 				if (index > before && index < after) {
-					// Index is inside an atom, determine on which side we want the cursor
-					// This is the only place where MOVE_LEFT/RIGHT and MOVE_*_OPT differ
-					// for the OPT version we must check if we are actually past any real characters
-					// but, if the atom is empty, it still counts as a single character!
-					if (dir == MOVE_LEFT) {
-						return cursor;
-					} else if (dir == MOVE_RIGHT) {
-						return cursor + 1;
-					} else if (dir == MOVE_LEFT_OPT) {
-						// is there any non-tag after index?
-						bool empty = true;
-						while (i < close) {
-							c = str.GetChar(i);
-							if (c == _('<')) {
-								i = skip_tag(str, i);
-							} else if (i >= index) {
-								return cursor; // this is a non-tag character after index
-							} else {
-								empty = false;
-								++i;
-							}
-						}
-						return empty ? cursor : cursor + 1; // still didn't pass any
-					} else if (dir == MOVE_RIGHT_OPT) {
-						// is index actually past any non-tag?
-						while (i < close) {
-							if (i >= index) {
-								return cursor; // we didn't pass any non-tag stuff
-							}
-							c = str.GetChar(i);
-							if (c != _('<')) break;
-							i = skip_tag(str, i);
-						}
-						return cursor + 1; // yes it is
-					} else if (dir == MOVE_MID) {
-						// count number of actual characters before/after
-						int before_c = 0;
-						int after_c  = 0;
-						while (i < close) {
-							c = str.GetChar(i);
-							if (c == _('<')) {
-								i = skip_tag(str, i);
-							} else {
-								if (i < index) before_c++;
-								else           after_c++;
-								++i;
-							}
-						}
-						// take the closest side
-						return before_c <= after_c ? cursor : cursor + 1;
-					}
+					return index_to_cursor_in_atom(str, before, index, cursor, dir);
 				}
 				i = after;
 			} else if (i == 0 && is_substr(str, i, _("<prefix"))) {
@@ -335,9 +348,8 @@ void cursor_to_index_range(const String& str, size_t cursor, size_t& start, size
 	end = max(end, start + 1); // always start < end, since there are always valid cursor positions
 }
 
-size_t cursor_to_index(const String& str, size_t cursor, Movement dir) {
-	size_t start, end;
-	cursor_to_index_range(str, cursor, start, end);
+/// cursor_to_index for a cursor with the index range [start...end)
+static size_t cursor_range_to_index(const String& str, size_t start, size_t end, Movement dir) {
 	if (dir == MOVE_MID) {
 		// find the middle between start and end
 		// if the string in between contains a pair "<tag></tag>" or "</tag><tag>" returns the middle
@@ -365,6 +377,65 @@ size_t cursor_to_index(const String& str, size_t cursor, Movement dir) {
 	return dir <= 0 /*MOVE_LEFT*/ ? start : end - 1;
 }
 
+size_t cursor_to_index(const String& str, size_t cursor, Movement dir) {
+	size_t start, end;
+	cursor_to_index_range(str, cursor, start, end);
+	return cursor_range_to_index(str, start, end, dir);
+}
+
+CursorPositions::CursorPositions(const String& str)
+	: str(str), prefix_end(0), end(str.size())
+{
+	// the same scan as index_to_cursor and cursor_to_index_range
+	for (size_t i = 0 ; i < str.size() ; ) {
+		size_t before = i;
+		if (str.GetChar(i) == _('<')) {
+			if (is_substr(str, i, _("<atom")) || is_substr(str, i, _("<sep"))) {
+				// tag counts as a single 'character'
+				i = match_close_tag_end(str, i);
+			} else if (i == 0 && is_substr(str, i, _("<prefix"))) {
+				// prefix at start of string, index never before
+				prefix_end = i = match_close_tag_end(str, i);
+				continue;
+			} else if (is_substr(str, i, _("<suffix")) && match_close_tag_end(str,i) >= str.size()) {
+				// suffix at end of string, there are no cursor positions in it
+				end = i;
+				break;
+			} else {
+				i = skip_tag(str, i);
+				continue;
+			}
+		} else {
+			++i;
+		}
+		starts.push_back(before);
+		ends.push_back(i);
+	}
+}
+
+size_t CursorPositions::indexToCursor(size_t index, Movement dir) const {
+	index = min(index, str.size());
+	// the cursor is after all characters/atoms that end before index
+	size_t cursor = upper_bound(ends.begin(), ends.end(), index) - ends.begin();
+	if (cursor < starts.size() && index > starts[cursor] && str.GetChar(starts[cursor]) == _('<')) {
+		return index_to_cursor_in_atom(str, starts[cursor], index, cursor, dir);
+	}
+	return cursor;
+}
+
+size_t CursorPositions::cursorToIndex(size_t cursor, Movement dir) const {
+	// same range as cursor_to_index_range
+	size_t range_start, range_end;
+	if (cursor > starts.size()) {
+		range_start = range_end = end;
+	} else {
+		range_start = cursor == 0 ? prefix_end : ends[cursor - 1];
+		range_end   = cursor < starts.size() ? starts[cursor] + 1 : end;
+	}
+	range_end = max(range_end, range_start + 1);
+	return cursor_range_to_index(str, range_start, range_end, dir);
+}
+
 String untag_for_cursor(const String& str) {
 	String ret; ret.reserve(str.size());
 	for (size_t i = 0 ; i < str.size() ; ) {
@@ -430,12 +501,60 @@ size_t index_to_untagged(const String& str, size_t index) {
 	return p;
 }
 
+TaggedPositions::TaggedPositions(const String& str)
+	: end(str.size())
+{
+	chars.reserve(str.size());
+	TagRun no_tags = {String::npos, String::npos};
+	tags.push_back(no_tags);
+	for (size_t i = 0 ; i < str.size() ; ) {
+		if (str.GetChar(i) == _('<')) {
+			size_t& first = is_substr(str, i, _("</")) ? tags.back().first_close : tags.back().first_open;
+			if (first == String::npos) first = i;
+			i = skip_tag(str, i);
+			if (i == String::npos) end = String::npos; // unclosed tag, the rest of the string is ignored
+		} else {
+			chars.push_back(i);
+			tags.push_back(no_tags);
+			++i;
+		}
+	}
+}
+
+size_t TaggedPositions::untaggedToIndex(size_t pos, bool inside) const {
+	if (pos > chars.size()) return end;
+	// stop at the first close tag (inside) or open tag (!inside) before the character
+	const TagRun& run = tags[pos];
+	size_t tag = inside ? run.first_close : run.first_open;
+	if (tag != String::npos) return tag;
+	return pos < chars.size() ? chars[pos] : end;
+}
+
+size_t TaggedPositions::indexToUntagged(size_t index) const {
+	return lower_bound(chars.begin(), chars.end(), index) - chars.begin();
+}
+
 // ----------------------------------------------------------------------------- : Global operations
 
 String remove_tag(const String& str, const String& tag) {
 	if (tag.size() < 1)  return str;
 	String ctag = close_tag(tag);
-	return remove_tag_exact(remove_tag_exact(str, tag), ctag);
+	// remove open and close tags in a single pass
+	size_t start = 0;
+	size_t open_pos = str.find(tag), close_pos = str.find(ctag);
+	if (open_pos == String::npos && close_pos == String::npos) return str; // no need to copy
+	String ret; ret.reserve(str.size());
+	while (open_pos != String::npos || close_pos != String::npos) {
+		size_t pos = min(open_pos, close_pos);
+		ret.append(str, start, pos - start); // before
+		// next
+		start = skip_tag(str, pos);
+		if (start > str.size()) break;
+		if (open_pos  < start) open_pos  = str.find(tag,  start);
+		if (close_pos < start) close_pos = str.find(ctag, start);
+	}
+	if (start < str.size()) ret.append(str, start, String::npos);
+	return ret;
 }
 
 String remove_tag_exact(const String& str, const String& tag) {
@@ -443,13 +562,13 @@ String remove_tag_exact(const String& str, const String& tag) {
 	if (pos == String::npos) return str; // no need to copy
 	String ret; ret.reserve(str.size());
 	while (pos != String::npos) {
-		ret += str.substr(start, pos - start); // before
+		ret.append(str, start, pos - start); // before
 		// next
 		start = skip_tag(str, pos);
 		if (start > str.size()) break;
 		pos = str.find(tag, start);
 	}
-	ret += str.substr(start);
+	if (start < str.size()) ret.append(str, start, String::npos);
 	return ret;
 }
 
@@ -460,13 +579,13 @@ String remove_tag_contents(const String& str, const String& tag) {
 	while (pos != String::npos) {
 		size_t end = match_close_tag(str, pos);
 		if (end == String::npos) return ret; // missing close tag
-		ret += str.substr(start, pos - start);
+		ret.append(str, start, pos - start);
 		// next
 		start = skip_tag(str, end);
 		if (start > str.size()) break;
 		pos = str.find(tag, start);
 	}
-	ret += str.substr(start);
+	if (start < str.size()) ret.append(str, start, String::npos);
 	return ret;
 }
 
@@ -496,8 +615,6 @@ String get_tags(const String& str, size_t start, size_t end, bool open_tags, boo
 
 String tagged_substr_replace(const String& input, size_t start, size_t end, const String& replacement) {
 	assert(start <= end);
-	size_t size = input.size();
-	String ret; ret.reserve(size + replacement.size() - (end - start)); // estimated size
 	String collect_tags = simplify_tagged_merge(get_tags(input, start, end, true, true),true);
 	return simplify_tagged(
 		substr_replace(input, start, end,
@@ -507,10 +624,46 @@ String tagged_substr_replace(const String& input, size_t start, size_t end, cons
 		));
 }
 
+String tagged_substr_replace(const String& input, const vector<pair<size_t,size_t> >& sections, const String& replacement) {
+	String ret; ret.reserve(input.size());
+	size_t pos = 0;
+	for (size_t i = 0 ; i < sections.size() ; ++i) {
+		size_t start = sections[i].first, end = sections[i].second;
+		assert(pos <= start && start <= end);
+		String collect_tags = simplify_tagged_merge(get_tags(input, start, end, true, true),true);
+		ret.append(input, pos, start - pos); // before
+		ret += get_tags(collect_tags, 0, collect_tags.size(), false, true); // close tags
+		ret += replacement;
+		ret += get_tags(collect_tags, 0, collect_tags.size(), true, false); // open tags
+		pos = end;
+	}
+	ret.append(input, pos, String::npos);
+	// simplify only once, simplifying in between would move the later sections
+	return simplify_tagged(ret);
+}
+
+String tagged_replace_all(const String& input, const String& find, const String& replacement, bool case_sensitive, bool whole_word) {
+	if (find.empty()) return input;
+	String untagged = untag(input);
+	TaggedPositions positions(input);
+	vector<pair<size_t,size_t> > sections;
+	for (size_t i = 0 ; i + find.size() <= untagged.size() ; ++i) {
+		if (whole_word && (!is_word_end(untagged, i - 1) || !is_word_end(untagged, i + find.size()))) continue;
+		if (case_sensitive ? is_substr(untagged, i, find) : is_substr_i(untagged, i, find)) {
+			sections.push_back(make_pair(positions.untaggedToIndex(i,               true),
+			                             positions.untaggedToIndex(i + find.size(), true)));
+			i += find.size() - 1;
+		}
+	}
+	if (sections.empty()) return input;
+	return tagged_substr_replace(input, sections, replacement);
+}
+
 
 // ----------------------------------------------------------------------------- : Simplification
 
 String simplify_tagged(const String& str) {
+	if (str.find_first_of(_('<')) == String::npos) return str; // no tags to simplify
 	return simplify_tagged_overlap(simplify_tagged_merge(str));
 }
 
@@ -119,6 +119,27 @@ void cursor_to_index_range(const String& str, size_t cursor, size_t& begin, size
 /// Find the character index corresponding to the given cursor position
 size_t cursor_to_index(const String& str, size_t cursor, Movement dir = MOVE_MID);
 
+/// Mapping between cursor positions and character indices in a string
+/** Built with a single pass over the string, after that positions can be converted without rescanning.
+ *  Use this instead of index_to_cursor/cursor_to_index when converting many positions in the same string.
+ */
+class CursorPositions {
+  public:
+	CursorPositions(const String& str);
+	
+	/// Same as index_to_cursor(str, index, dir)
+	size_t indexToCursor(size_t index, Movement dir = MOVE_MID) const;
+	/// Same as cursor_to_index(str, cursor, dir)
+	size_t cursorToIndex(size_t cursor, Movement dir = MOVE_MID) const;
+	
+  private:
+	String         str;
+	vector<size_t> starts;     ///< Start of each character or atom that has a cursor position before it
+	vector<size_t> ends;       ///< End of each of those
+	size_t         prefix_end; ///< End of a <prefix> at the start of the string, or 0
+	size_t         end;        ///< Start of a <suffix> at the end of the string, or str.size()
+};
+
 
 const Char UNTAG_ATOM       = _('\2');
 const Char UNTAG_SEP        = _('\3');
@@ -143,6 +164,29 @@ size_t untagged_to_index(const String& str, size_t pos, bool inside, size_t star
  */
 size_t index_to_untagged(const String& str, size_t index);
 
+/// Mapping between tagged and untagged positions in a string
+/** Built with a single pass over the string, after that positions can be converted without rescanning.
+ *  Use this instead of untagged_to_index/index_to_untagged when converting many positions in the same string.
+ */
+class TaggedPositions {
+  public:
+	TaggedPositions(const String& str);
+	
+	/// Same as untagged_to_index(str, pos, inside)
+	size_t untaggedToIndex(size_t pos, bool inside) const;
+	/// Same as index_to_untagged(str, index)
+	size_t indexToUntagged(size_t index) const;
+	
+  private:
+	/// The first open and close tags in a run of tags
+	struct TagRun {
+		size_t first_open, first_close;
+	};
+	vector<size_t> chars; ///< Index of each untagged character
+	vector<TagRun> tags;  ///< Tags directly before each untagged character, and before the end
+	size_t         end;   ///< Where scanning stopped, str.size(), or String::npos for an unclosed tag
+};
+
 // ----------------------------------------------------------------------------- : Global operations
 
 /// Remove all instances of a tag and its close tag, but keep the contents.
@@ -178,6 +222,18 @@ String get_tags(const String& str, size_t start, size_t end, bool open_tags, boo
  */
 String tagged_substr_replace(const String& input, size_t start, size_t end, const String& replacement);
 
+/// Replace several subsections of 'input' with 'replacement', like tagged_substr_replace.
+/** The sections must be in order and must not overlap.
+ *  The result is only simplified at the end, so all positions refer to the original input.
+ */
+String tagged_substr_replace(const String& input, const vector<pair<size_t,size_t> >& sections, const String& replacement);
+
+/// Replace all occurences of 'find' in the untagged text of 'input' with 'replacement'.
+/** A match can span tags, those tags are kept as in tagged_substr_replace.
+ *  Does not escape the replacement.
+ */
+String tagged_replace_all(const String& input, const String& find, const String& replacement, bool case_sensitive, bool whole_word);
+
 // ----------------------------------------------------------------------------- : Simplification
 
 /// Verify that a string is correctly tagged
@@ -24,6 +24,11 @@ test_case("script/Builtin Funcions", sub{
 	compare_files("textfile1.out.txt", "expected-out/textfile1.out.txt");
 });
 
+test_case("script/Constant folding", sub{
+	run_script_test("test-constant-folding.mse-script");
+	compare_files("test-constant-folding.out", "expected-out/test-constant-folding.out");
+});
+
 test_case("script/Magic Funcions", sub{
 	write_dummy_set("_dummy-magic-set.mse-set", "game: magic\nstylesheet: new\n");
 	run_script_test("test-magic.mse-script", set => "_dummy-magic-set.mse-set");
@@ -31,6 +36,13 @@ test_case("script/Magic Funcions", sub{
 	compare_files("test-magic.out", "expected-out/test-magic.out");
 });
 
+test_case("script/Pack simulation threads", sub{
+	# the same seed must give the same statistics, regardless of the number of threads
+	run_cli_test(":simulate -j1 20000 123 booster pack\n", "simulate-1.out", set => "simple-magic-2.0.0.mse-set");
+	run_cli_test(":simulate -j4 20000 123 booster pack\n", "simulate-4.out", set => "simple-magic-2.0.0.mse-set");
+	compare_files("simulate-4.out", "simulate-1.out");
+});
+
 test_case("compatability/2.0.0", sub{
 	mkdir("out");
 	run_export_test("magic-forum", "simple-magic-2.0.0.mse-set", "out/simple-magic-2.0.0.txt", cleanup => 1);
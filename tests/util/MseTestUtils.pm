@@ -8,7 +8,7 @@ package MseTestUtils;
 
 require Exporter;
 @ISA = qw(Exporter);
-@EXPORT = qw(run_script_test run_export_test file_set_contents write_dummy_set remove_dummy_set compare_files); 
+@EXPORT = qw(run_script_test run_cli_test run_export_test file_set_contents write_dummy_set remove_dummy_set compare_files); 
 
 use strict;
 use File::Basename;
@@ -37,7 +37,7 @@ sub run_script_test {
 	my $cleanup  = $opts{cleanup} // 0;
 	my $outfile  = basename($script,".mse-script") . ".out";
 	my $errfile  = basename($script,".mse-script") . ".err";
-	my $command  = "$MAGICSETEDITOR --cli --quiet --script \"$script\" $args > \"$outfile\" 2> \"$errfile\"";
+	my $command  = "$MAGICSETEDITOR --cli --quiet --test --script \"$script\" $args > \"$outfile\" 2> \"$errfile\"";
 	print "$command\n";
 	#`$command`;
 	my $errcode = system($command);
@@ -58,6 +58,29 @@ sub run_script_test {
 	}
 }
 
+# Run commands in the command line interface, for commands that are not script functions
+sub run_cli_test {
+	my $commands = shift;
+	my $outfile  = shift;
+	my %opts     = @_;
+	my $args     = defined($opts{set}) ? "\"$opts{set}\"" : '';
+	my $ignore_locale_errors = $opts{ignore_locale_errors} // 1;
+	my $infile   = basename($outfile,".out") . ".in";
+	my $errfile  = basename($outfile,".out") . ".err";
+	file_set_contents($infile, $commands);
+	my $command  = "$MAGICSETEDITOR --cli --quiet $args < \"$infile\" > \"$outfile\" 2> \"$errfile\"";
+	print "$command\n";
+	my $errcode = system($command);
+	if ($errcode != 0) {
+		print "Invoking Magic Set Editor failed\n";
+		fail_current_test();
+	}
+	
+	# Check for errors / warnings
+	check_for_errors($errfile, $ignore_locale_errors);
+	unlink($infile);
+}
+
 # Invoke an export template
 sub run_export_test {
 	my $template = shift;